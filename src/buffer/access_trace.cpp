@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// access_trace.cpp
+//
+// Identification: src/buffer/access_trace.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/access_trace.h"
+
+#include <fstream>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+AccessTrace::AccessTrace(size_t capacity)
+    : capacity_(capacity), slots_(new Slot[capacity]), start_(std::chrono::steady_clock::now()) {
+  BUSTUB_ASSERT(capacity > 0, "An access trace needs room for at least one access.");
+}
+
+void AccessTrace::Record(page_id_t page_id, AccessType type) {
+  const auto time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+  Slot &slot = slots_[next_slot_.fetch_add(1, std::memory_order_relaxed) % capacity_];
+  slot.time_ns_.store(time_ns.count(), std::memory_order_relaxed);
+  slot.page_id_.store(page_id, std::memory_order_relaxed);
+  slot.type_.store(type, std::memory_order_relaxed);
+}
+
+std::vector<AccessTrace::Entry> AccessTrace::GetEntries() const {
+  const uint64_t end = next_slot_.load();
+  const uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+  std::vector<Entry> entries;
+  entries.reserve(end - begin);
+  for (uint64_t i = begin; i < end; i++) {
+    const Slot &slot = slots_[i % capacity_];
+    entries.push_back(Entry{slot.time_ns_.load(std::memory_order_relaxed),
+                            slot.page_id_.load(std::memory_order_relaxed), slot.type_.load(std::memory_order_relaxed)});
+  }
+  return entries;
+}
+
+bool AccessTrace::Dump(const std::string &file_name) const {
+  std::ofstream out(file_name, std::ios::trunc);
+  for (const auto &entry : GetEntries()) {
+    out << entry.time_ns_ << ' ' << TypeName(entry.type_) << ' ' << entry.page_id_ << '\n';
+  }
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+const char *AccessTrace::TypeName(AccessType type) {
+  switch (type) {
+    case AccessType::HIT:
+      return "hit";
+    case AccessType::MISS:
+      return "miss";
+    case AccessType::NEW:
+      return "new";
+    case AccessType::UNPIN:
+      return "unpin";
+    case AccessType::DELETE:
+      return "delete";
+    case AccessType::EVICT:
+      return "evict";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
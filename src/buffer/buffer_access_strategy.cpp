@@ -0,0 +1,35 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+BufferAccessStrategy::BufferAccessStrategy(size_t ring_size) : ring_(ring_size, INVALID_PAGE_ID) {
+  BUSTUB_ASSERT(ring_size > 0, "A buffer access strategy needs at least one slot.");
+}
+
+void BufferAccessStrategy::RecordLoad(page_id_t page_id) {
+  retired_page_id_ = ring_[next_slot_];
+  ring_[next_slot_] = page_id;
+  next_slot_ = (next_slot_ + 1) % ring_.size();
+}
+
+page_id_t BufferAccessStrategy::TakeRetiredPage() {
+  page_id_t page_id = retired_page_id_;
+  retired_page_id_ = INVALID_PAGE_ID;
+  return page_id;
+}
+
+}  // namespace bustub
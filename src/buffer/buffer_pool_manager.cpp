@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager.cpp
+//
+// Identification: src/buffer/buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace bustub {
+
+/** Hot set files start with this magic number, followed by the number of page ids and the page ids themselves. */
+static constexpr uint32_t HOT_SET_MAGIC = 0x48545354;
+
+bool BufferPoolManager::SaveHotSet(const std::string &file_name) {
+  std::vector<page_id_t> hot_set = GetHotSet();
+  // write a temporary file and rename it over the old one, so a crash never leaves a torn hot set behind
+  const std::string tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    const auto count = static_cast<uint32_t>(hot_set.size());
+    out.write(reinterpret_cast<const char *>(&HOT_SET_MAGIC), sizeof(HOT_SET_MAGIC));
+    out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char *>(hot_set.data()), hot_set.size() * sizeof(page_id_t));
+    out.flush();
+    if (!out) {
+      std::remove(tmp_file_name.c_str());
+      return false;
+    }
+  }
+  return std::rename(tmp_file_name.c_str(), file_name.c_str()) == 0;
+}
+
+bool BufferPoolManager::LoadHotSet(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary | std::ios::ate);
+  const auto file_size = static_cast<size_t>(in.tellg());
+  in.seekg(0);
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!in || magic != HOT_SET_MAGIC || file_size != sizeof(magic) + sizeof(count) + count * sizeof(page_id_t)) {
+    return false;
+  }
+  std::vector<page_id_t> hot_set(count);
+  in.read(reinterpret_cast<char *>(hot_set.data()), hot_set.size() * sizeof(page_id_t));
+  if (!in) {
+    return false;
+  }
+  WarmUp(hot_set);
+  return true;
+}
+
+Page *BufferPoolManager::NewPageInSegment(page_id_t *page_id, Segment *segment) {
+  std::scoped_lock latch(segment->latch_);
+  if (segment->extent_ == nullptr || segment->extent_->next_page_id_ == segment->extent_->end_page_id_) {
+    segment->extent_ = AllocateExtentImp(segment->extent_size_);
+    if (segment->extent_ == nullptr) {
+      return NewPage(page_id);
+    }
+  }
+  // The id is taken before its page exists, so that bitmaps written meanwhile already count it as allocated. It is
+  // given back if no frame is free, so that a pool without a free frame does not leave a hole in the extent.
+  const page_id_t next_page_id = segment->extent_->next_page_id_++;
+  Page *page = NewPgWithIdImp(next_page_id);
+  if (page == nullptr) {
+    segment->extent_->next_page_id_--;
+    return nullptr;
+  }
+  *page_id = next_page_id;
+  return page;
+}
+
+}  // namespace bustub
@@ -12,40 +12,101 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <future>  // NOLINT
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
 #include "common/macros.h"
 
 #include "common/logger.h"
 
 namespace bustub {
 
+/**
+ * Map the data arena of a buffer pool. Anonymous memory comes zeroed and page aligned, and the OS only backs the parts
+ * of it that are touched.
+ */
+static char *MapDataArena(size_t size) {
+  void *arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the buffer pool's data arena");
+  }
+#ifdef MADV_HUGEPAGE
+  // Transparent huge pages cut the TLB misses of touching many frames. It is only a hint: the kernel falls back to
+  // small pages when it has no huge pages to spare.
+  if (BUFFER_POOL_HUGE_PAGES) {
+    madvise(arena, size, MADV_HUGEPAGE);
+  }
+#endif
+  return static_cast<char *>(arena);
+}
+
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size, size_t compressed_cache_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, max_pool_size,
+                                compressed_cache_size) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size),
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
+    : max_pool_size_(std::max(pool_size, max_pool_size)),
+      pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      page_table_(PAGE_TABLE_SHARDS) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  BUSTUB_ASSERT(pool_size > 0, "The buffer pool needs at least one frame.");
+  // We allocate a consecutive memory space for the buffer pool, large enough for the pool to grow into. Frames are
+  // constructed as the pool grows, so the memory of frames that are not in use yet is never touched. The descriptors
+  // and the page data are kept apart, so that scans over the descriptors do not stride over the page data.
+  pages_ = static_cast<Page *>(::operator new(max_pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  data_arena_ = MapDataArena(max_pool_size_ * PAGE_SIZE);
+  if (compressed_cache_size > 0) {
+    compressed_cache_ = std::make_unique<CompressedPageCache>(compressed_cache_size);
+  }
+  // Replacers index their state by frame id, so they are sized for every frame the pool may ever use.
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRUK:
+      replacer_ = new LRUKReplacer(max_pool_size_, LRUK_REPLACER_K, LRUK_CORRELATED_PERIOD);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(data_arena_ + i * PAGE_SIZE);
     free_list_.emplace_back(static_cast<int>(i));
   }
+  num_free_frames_ = free_list_.size();
+  constructed_frames_ = pool_size_;
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopPrefetching();
+  StopBackgroundWriter();
+  for (size_t i = 0; i < constructed_frames_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_, std::align_val_t{alignof(Page)});
+  munmap(data_arena_, max_pool_size_ * PAGE_SIZE);
   delete replacer_;
 }
 
@@ -53,23 +114,71 @@ bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
   // 刷新进磁盘，数据不dirty了
   ValidatePageId(page_id);
-  latch_.lock();
-  if (page_table_.find(page_id) != page_table_.end()) {
-    Page *p = &pages_[page_table_[page_id]];
-    disk_manager_->WritePage(page_id, p->data_);
-    p->is_dirty_ = false;
-    latch_.unlock();
-    return true;
-  }
-  latch_.unlock();
-  return false;
+  // The shard latch is held across the write, so the frame cannot be evicted and reused underneath us. A frame that
+  // is still being loaded holds a clean page (and possibly the previous page's bytes), so there is nothing to write.
+  return page_table_.Find(page_id, [&](frame_id_t frame_id) {
+    Page *p = &pages_[frame_id];
+    if (!p->io_in_progress_) {
+      MarkClean(p);
+      disk_manager_->WritePage(page_id, p->data_);
+      flushes_++;
+    }
+  });
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  for (auto page : page_table_) {
-    page_id_t page_id = page.first;
-    FlushPgImp(page_id);
+  WriteAllDirtyPages();
+  disk_manager_->Sync();
+}
+
+void BufferPoolManagerInstance::WriteAllDirtyPages() {
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+    if (pages_[frame_id].IsDirty()) {
+      dirty.emplace_back(page_id, frame_id);
+    }
+  });
+  std::sort(dirty.begin(), dirty.end());
+
+  // Each batch is claimed page by page, so its frames cannot be evicted while it is written, and released right after.
+  // The disk manager writes the runs of adjacent pages in a batch with one call each.
+  std::vector<Page *> batch;
+  std::vector<std::pair<page_id_t, const char *>> batch_data;
+  auto write_batch = [&] {
+    if (batch.empty()) {
+      return;
+    }
+    for (Page *p : batch) {
+      MarkClean(p);
+    }
+    disk_manager_->WritePages(batch_data);
+    flushes_ += batch.size();
+    for (Page *p : batch) {
+      FinishWriteback(p);
+    }
+    batch.clear();
+    batch_data.clear();
+  };
+  // pages the background writer is writing out right now; they are on disk once it is done with them
+  std::vector<Page *> busy;
+  for (const auto &[page_id, frame_id] : dirty) {
+    Page *p = &pages_[frame_id];
+    bool writing = false;
+    if (!ClaimWriteback(page_id, frame_id, &writing)) {
+      if (writing) {
+        busy.push_back(p);
+      }
+      continue;
+    }
+    if (batch.size() >= static_cast<size_t>(FLUSH_RUN_SIZE)) {
+      write_batch();
+    }
+    batch.push_back(p);
+    batch_data.emplace_back(page_id, p->data_);
+  }
+  write_batch();
+  for (Page *p : busy) {
+    WaitForWriteback(p);
   }
 }
 
@@ -79,57 +188,164 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  latch_.lock();
+  std::unique_lock latch = AcquireLatch();
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id)) {
+    pin_failures_++;
+    return nullptr;
+  }
+  *page_id = AllocatePage();
+  Trace(*page_id, AccessType::NEW);
+  return LoadFrame(frame_id, *page_id, false, true, &latch);
+}
+
+Page *BufferPoolManagerInstance::NewPgWithIdImp(page_id_t page_id) {
+  ValidatePageId(page_id);
+  std::unique_lock latch = AcquireLatch();
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id)) {
+    pin_failures_++;
+    return nullptr;
+  }
+  Trace(page_id, AccessType::NEW);
+  return LoadFrame(frame_id, page_id, false, true, &latch);
+}
+
+std::shared_ptr<Extent> BufferPoolManagerInstance::AllocateExtentImp(size_t num_pages) {
+  return disk_manager_->AllocateExtent(num_pages);
+}
+
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchFrame(page_id, true); }
+
+Page *BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  bool first_fetch;
+  Page *p = FetchFrame(page_id, true, &first_fetch);
+  if (p != nullptr && first_fetch) {
+    strategy->RecordLoad(page_id);
+  }
+  return p;
+}
+
+void BufferPoolManagerInstance::RetirePgImp(page_id_t page_id) {
+  ValidatePageId(page_id);
+  std::unique_lock latch = AcquireLatch();
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return;
+  }
+  // a scan that keeps retiring pages nobody evicts must not grow the list without bound
+  if (retired_frames_.size() >= pool_size_) {
+    retired_frames_.pop_front();
+  }
+  retired_frames_.emplace_back(frame_id, page_id);
+}
+
+Page *BufferPoolManagerInstance::PeekPgImp(page_id_t page_id) {
+  ValidatePageId(page_id);
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  return &pages_[frame_id];
+}
+
+Page *BufferPoolManagerInstance::FetchResidentPgImp(page_id_t page_id) {
+  ValidatePageId(page_id);
   Page *p = nullptr;
-  // pick a page from the free list first
-  if (!free_list_.empty()) {
-    // next page id in the bpi
-    *page_id = next_page_id_;
-    next_page_id_ += num_instances_;
-    ValidatePageId(*page_id);
+  // pinning under the shard latch keeps DeletePgImp from freeing the page, which only removes unpinned pages
+  if (!page_table_.Find(page_id, [&](frame_id_t frame_id) {
+        PinFrame(frame_id, true);
+        p = &pages_[frame_id];
+      })) {
+    return nullptr;
+  }
+  CountHit(page_id);
+  WaitForIo(p);
+  return p;
+}
 
-    frame_id_t frame_id = free_list_.front();  // find a frame for the page
-    free_list_.pop_front();
-    page_table_[*page_id] = frame_id;
-    replacer_->Pin(frame_id);
-    p = &pages_[frame_id];
-    p->ResetMemory();
-    // disk_manager_->ReadPage(*page_id, p->data_);
-
-    p->page_id_ = *page_id;
-    p->is_dirty_ = false;
-    p->pin_count_ = 1;
-  } else {
-    frame_id_t r;
-    // find a frame from replacer
-    if (replacer_->Victim(&r)) {
-      *page_id = next_page_id_;
-      next_page_id_ += num_instances_;
-
-      p = &pages_[r];
-      if (p->IsDirty()) {
-        disk_manager_->WritePage(p->page_id_, p->data_);
-        p->is_dirty_ = false;
-      }
-      page_table_[*page_id] = r;
-      p->ResetMemory();
-      if (p->page_id_ != INVALID_PAGE_ID) {
-        page_table_.erase(p->page_id_);
+bool BufferPoolManagerInstance::ResizePoolImp(size_t pool_size) {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::scoped_lock resize_latch(resize_latch_);
+  std::unique_lock latch(latch_);
+  size_t new_pool_size = pool_size_;
+  if (pool_size > new_pool_size) {
+    for (; new_pool_size < pool_size; ++new_pool_size) {
+      if (new_pool_size == constructed_frames_) {
+        new (&pages_[new_pool_size]) Page(data_arena_ + new_pool_size * PAGE_SIZE);
+        constructed_frames_++;
       }
-      // disk_manager_->ReadPage(*page_id, p->data_);
-      disk_manager_->WritePage(*page_id, p->data_);
-      p->page_id_ = *page_id;
-      p->is_dirty_ = false;
-      p->pin_count_ = 1;
-      replacer_->Pin(r);
+      free_list_.emplace_back(static_cast<frame_id_t>(new_pool_size));
     }
+    num_free_frames_ = free_list_.size();
   }
-  latch_.unlock();
-  // LOG_DEBUG("HERE:%d\n",*page_id);
-  return p;
+  // give up frames from the end, so that the frames in use stay a prefix of pages_
+  while (new_pool_size > pool_size && WithdrawFrame(static_cast<frame_id_t>(new_pool_size - 1), &latch)) {
+    --new_pool_size;
+  }
+  pool_size_ = new_pool_size;
+  writer_low_pages_ = static_cast<size_t>(writer_low_watermark_ * new_pool_size);
+  writer_high_pages_ = static_cast<size_t>(writer_high_watermark_ * new_pool_size);
+  return new_pool_size == pool_size;
 }
 
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
+bool BufferPoolManagerInstance::WithdrawFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *latch) {
+  Page *p = &pages_[frame_id];
+  // With latch_ held, a frame holds no page exactly when it is on the free list.
+  if (p->page_id_ == INVALID_PAGE_ID) {
+    free_list_.remove(frame_id);
+    num_free_frames_ = free_list_.size();
+    return true;
+  }
+  const page_id_t page_id = p->page_id_;
+  while (true) {
+    bool writing = false;
+    if (page_table_.RemoveIf(page_id, [p, frame_id, &writing](frame_id_t resident_frame_id) {
+          writing = p->writeback_in_progress_;
+          return resident_frame_id == frame_id && !writing && p->GetPinCount() == 0;
+        })) {
+      break;
+    }
+    if (!writing) {
+      return false;
+    }
+    latch->unlock();
+    WaitForWriteback(p);
+    latch->lock();
+  }
+  replacer_->Remove(frame_id);
+
+  // Write the page back like an eviction does: a fetch of the page waits for the write instead of reading stale data.
+  if (p->IsDirty()) {
+    writeback_pages_[page_id] = frame_id;
+    {
+      std::scoped_lock io_latch(p->io_latch_);
+      p->io_in_progress_ = true;
+    }
+    latch->unlock();
+    MarkClean(p);
+    disk_manager_->WritePage(page_id, p->data_);
+    writebacks_++;
+    latch->lock();
+    writeback_pages_.erase(page_id);
+    FinishIo(p);
+  }
+  p->version_.fetch_add(1);
+  // Hand the frame's memory back to the OS. Frames are always cleared before they are loaded, so it does not matter
+  // whether the memory comes back zeroed.
+  if (PAGE_SIZE % sysconf(_SC_PAGESIZE) != 0 || madvise(p->data_, PAGE_SIZE, MADV_DONTNEED) != 0) {
+    p->ResetMemory();
+  }
+  p->page_id_ = INVALID_PAGE_ID;
+  p->pin_count_ = 0;
+  p->fetched_ = false;
+  p->version_.fetch_add(1);
+  return true;
+}
+
+Page *BufferPoolManagerInstance::FetchFrame(page_id_t page_id, bool record_access, bool *first_fetch) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -137,57 +353,73 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-
   ValidatePageId(page_id);
   Page *p = nullptr;
-  latch_.lock();
-  // if the page p in buffer pool,return it and pin it
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id_t frame_id = page_table_[page_id];
+  bool first = false;
+  auto pin = [&](frame_id_t frame_id) {
+    first = PinFrame(frame_id, record_access);
     p = &pages_[frame_id];
-    p->pin_count_++;
-
-    if (p->pin_count_ == 1) {
-      replacer_->Pin(frame_id);
+  };
+  if (first_fetch != nullptr) {
+    *first_fetch = false;
+  }
+  // if the page p in buffer pool,return it and pin it
+  if (page_table_.Find(page_id, pin)) {
+    if (record_access) {
+      CountHit(page_id);
     }
-  } else {
-    // if p not in buffer,find it from disk
-    if (!free_list_.empty()) {
-      // find a replacement page from the free lists
-      frame_id_t r = free_list_.front();
-      free_list_.pop_front();
-      page_table_[page_id] = r;
-      p = &pages_[r];
-      if (p->IsDirty()) {
-        disk_manager_->WritePage(p->GetPageId(), p->GetData());
-        p->is_dirty_ = false;
+    WaitForIo(p);
+    if (first_fetch != nullptr) {
+      *first_fetch = first;
+    }
+    return p;
+  }
+
+  std::unique_lock latch = AcquireLatch();
+  while (true) {
+    // another thread may have started reading the page in while we were waiting for the latch
+    if (page_table_.Find(page_id, pin)) {
+      latch.unlock();
+      if (record_access) {
+        CountHit(page_id);
       }
-      p->ResetMemory();
-      p->page_id_ = page_id;
-      p->pin_count_ = 1;
-      replacer_->Pin(r);
-      disk_manager_->ReadPage(page_id, p->data_);
-    } else {
-      // find a replacement page from replacer,there is no page in free lists
-      frame_id_t r;
-      if (replacer_->Victim(&r)) {
-        page_table_[page_id] = r;
-        p = &pages_[r];
-        page_table_.erase(p->page_id_);
-        if (p->IsDirty()) {
-          disk_manager_->WritePage(p->page_id_, p->data_);
-          p->is_dirty_ = false;
-        }
-        p->ResetMemory();
-        p->page_id_ = page_id;
-        p->pin_count_ = 1;
-        replacer_->Pin(r);
-        disk_manager_->ReadPage(page_id, p->data_);
+      WaitForIo(p);
+      if (first_fetch != nullptr) {
+        *first_fetch = first;
       }
+      return p;
     }
+    // the page was just evicted, wait until its dirty contents are on disk before reading it back
+    auto writeback = writeback_pages_.find(page_id);
+    if (writeback == writeback_pages_.end()) {
+      break;
+    }
+    Page *writer = &pages_[writeback->second];
+    latch.unlock();
+    WaitForIo(writer);
+    latch.lock();
   }
-  latch_.unlock();
-  return p;
+  // A deleted page is not read back in. Its id may be handed out again, and the new page must not find a stale copy
+  // of the old one resident. Pages are deallocated under the latch, so the check cannot race with DeletePgImp.
+  if (!disk_manager_->IsPageAllocated(page_id)) {
+    return nullptr;
+  }
+  // if p not in buffer,find it from disk
+  frame_id_t frame_id;
+  if (!GetVictimFrame(&frame_id)) {
+    if (record_access) {
+      pin_failures_++;
+    }
+    return nullptr;
+  }
+  if (first_fetch != nullptr) {
+    *first_fetch = record_access;
+  }
+  if (record_access) {
+    misses_++;
+    Trace(page_id, AccessType::MISS);
+  }
+  return LoadFrame(frame_id, page_id, true, record_access, &latch);
 }
 
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
@@ -197,84 +429,597 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   ValidatePageId(page_id);
-  latch_.lock();
-  if (page_table_.find(page_id) == page_table_.end()) {
-    latch_.unlock();
-    DeallocatePage(page_id);
-    return true;
-  }
-  frame_id_t frame_id = page_table_[page_id];
-  Page *p = &pages_[frame_id];
-  if (p->GetPinCount() != 0) {
-    latch_.unlock();
-    return false;
+  std::unique_lock latch = AcquireLatch();
+  frame_id_t frame_id;
+  Page *p;
+  while (true) {
+    // a deleted page's contents are never read again, so a dirty page is dropped without writing it back
+    if (!page_table_.Find(page_id, &frame_id)) {
+      // an evicted page may still be on its way into the compressed cache, where it must not outlive the deletion
+      auto leaving = writeback_pages_.find(page_id);
+      if (leaving != writeback_pages_.end()) {
+        Page *writer = &pages_[leaving->second];
+        latch.unlock();
+        WaitForIo(writer);
+        latch.lock();
+        continue;
+      }
+      if (compressed_cache_ != nullptr) {
+        compressed_cache_->Erase(page_id);
+      }
+      DeallocatePage(page_id);
+      Trace(page_id, AccessType::DELETE);
+      return true;
+    }
+    p = &pages_[frame_id];
+    bool writing = false;
+    if (page_table_.RemoveIf(page_id, [p, frame_id, &writing](frame_id_t resident_frame_id) {
+          if (resident_frame_id != frame_id) {
+            return false;
+          }
+          writing = p->writeback_in_progress_;
+          return !writing && p->GetPinCount() == 0;
+        })) {
+      break;
+    }
+    if (!writing) {
+      return false;
+    }
+    // the background writer is still using the frame, it must not go back to the free list before the write is done
+    latch.unlock();
+    WaitForWriteback(p);
+    latch.lock();
   }
 
   DeallocatePage(page_id);
-  replacer_->Pin(frame_id);
-  page_table_.erase(page_id);
-  if (p->IsDirty()) {
-    disk_manager_->WritePage(p->GetPageId(), p->GetData());
-  }
+  Trace(page_id, AccessType::DELETE);
+  replacer_->Remove(frame_id);
+  p->version_.fetch_add(1);
   p->ResetMemory();
-  p->is_dirty_ = false;
+  MarkClean(p);
   p->pin_count_ = 0;
   p->page_id_ = INVALID_PAGE_ID;
+  p->version_.fetch_add(1);
   free_list_.push_back(frame_id);
-  latch_.unlock();
+  num_free_frames_ = free_list_.size();
   return true;
 }
 
 bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   // this page_id should be in this bfpi
   ValidatePageId(page_id);
-  latch_.lock();
-  // page not in buffer
-  if (page_table_.find(page_id) == page_table_.end()) {
-    latch_.unlock();
-    return false;
-  }
-  // page in buffer
-  frame_id_t r = page_table_[page_id];
-  Page *p = &pages_[r];
-  // if (p->pin_count_ > 1) {
-  //   printf("pin_count:%d\n",p->pin_count_);
-  // }
-  if (is_dirty) {  // page is dirty
-    p->is_dirty_ = is_dirty;
-  }
-  if (p->pin_count_ > 0) {
-    p->pin_count_--;
-    if (p->pin_count_ == 0) {
-      replacer_->Unpin(r);
-    }
-    latch_.unlock();
-    return true;
+  bool unpinned = false;
+  page_table_.Find(page_id, [&](frame_id_t frame_id) {
+    Page *p = &pages_[frame_id];
+    if (is_dirty) {  // page is dirty
+      MarkDirty(p);
+    }
+    int pin_count = p->pin_count_;
+    while (pin_count > 0) {
+      if (p->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+        if (pin_count == 1) {
+          replacer_->Unpin(frame_id);
+        }
+        unpinned = true;
+        break;
+      }
+    }
+  });
+  if (unpinned) {
+    Trace(page_id, AccessType::UNPIN);
   }
-  latch_.unlock();
-  return false;
+  return unpinned;
 }
 
 page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+  // the disk manager only hands out page ids that mod back to this BPI
+  const page_id_t page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  ValidatePageId(page_id);
+  return page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
 
+bool BufferPoolManagerInstance::PinFrame(frame_id_t frame_id, bool record_access) {
+  // A concurrent unpin may still hand this frame to the replacer after we pinned it. GetVictimFrame re-checks the pin
+  // count under the exclusive shard latch, so such a stale replacer entry is skipped rather than evicted.
+  Page *p = &pages_[frame_id];
+  bool first_fetch = false;
+  if (record_access) {
+    replacer_->RecordAccess(frame_id);
+    first_fetch = !p->fetched_.load() && !p->fetched_.exchange(true);
+  }
+  if (p->pin_count_++ == 0) {
+    replacer_->Pin(frame_id);
+  }
+  return first_fetch;
+}
+
+bool BufferPoolManagerInstance::GetVictimFrame(frame_id_t *frame_id) {
+  // pick a frame from the free list first
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    num_free_frames_ = free_list_.size();
+    return true;
+  }
+  // then reuse the frames that scans are done with, unless someone pinned the page again since it was retired
+  while (!retired_frames_.empty()) {
+    auto [retired_frame_id, retired_page_id] = retired_frames_.front();
+    retired_frames_.pop_front();
+    Page *p = &pages_[retired_frame_id];
+    if (page_table_.RemoveIf(retired_page_id, [p, retired_frame_id](frame_id_t resident_frame_id) {
+          return resident_frame_id == retired_frame_id && !p->writeback_in_progress_ && p->GetPinCount() == 0;
+        })) {
+      replacer_->Remove(retired_frame_id);
+      *frame_id = retired_frame_id;
+      return true;
+    }
+  }
+  // While the background writer runs, pass over dirty frames so that this miss does not have to write one back.
+  const bool prefer_clean = writer_running_;
+  auto clean = [this](frame_id_t frame_id) {
+    return !pages_[frame_id].IsDirty() && !pages_[frame_id].writeback_in_progress_;
+  };
+  // find a frame from replacer, skipping frames that were re-pinned by a hit after the replacer handed them out and
+  // frames that the background writer is still writing out
+  std::vector<frame_id_t> busy;
+  bool found = false;
+  while (prefer_clean ? replacer_->PreferredVictim(frame_id, clean) : replacer_->Victim(frame_id)) {
+    Page *p = &pages_[*frame_id];
+    bool writing = false;
+    if (page_table_.RemoveIf(p->page_id_, [p, frame_id, &writing](frame_id_t resident_frame_id) {
+          if (resident_frame_id != *frame_id) {
+            return false;
+          }
+          writing = p->writeback_in_progress_;
+          return !writing && p->GetPinCount() == 0;
+        })) {
+      found = true;
+      break;
+    }
+    if (writing) {
+      busy.push_back(*frame_id);
+    }
+  }
+  // frames being written back are still unpinned, so they go back into the replacer
+  for (frame_id_t busy_frame_id : busy) {
+    replacer_->Unpin(busy_frame_id);
+  }
+  if (found && prefer_clean && pages_[*frame_id].IsDirty()) {
+    KickBackgroundWriter();
+  }
+  return found;
+}
+
+void BufferPoolManagerInstance::PublishFrame(frame_id_t frame_id, page_id_t page_id, bool record_access) {
+  Page *p = &pages_[frame_id];
+  // Optimistic readers of a victim page that are still looking at the frame see an odd version until it is loaded.
+  {
+    std::scoped_lock io_latch(p->io_latch_);
+    p->io_in_progress_ = true;
+  }
+  p->version_.fetch_add(1);
+  p->page_id_ = page_id;
+  p->pin_count_ = 1;
+  p->fetched_ = record_access;
+  if (record_access) {
+    replacer_->RecordAccess(frame_id);
+  }
+  [[maybe_unused]] bool inserted = page_table_.Insert(page_id, frame_id);
+  BUSTUB_ASSERT(inserted, "A page must not be resident in two frames.");
+}
+
+Page *BufferPoolManagerInstance::LoadFrame(frame_id_t frame_id, page_id_t page_id, bool read_page, bool record_access,
+                                           std::unique_lock<std::mutex> *latch) {
+  Page *p = &pages_[frame_id];
+  const page_id_t victim_page_id = p->page_id_;
+  const bool write_back = victim_page_id != INVALID_PAGE_ID && p->IsDirty();
+  const bool cache_victim = victim_page_id != INVALID_PAGE_ID && compressed_cache_ != nullptr;
+  // Fetches of the victim wait until it is written back and in the compressed cache. Otherwise a fetch could read the
+  // victim from disk, change it and write it out before a stale copy of it lands in the cache.
+  if (write_back || cache_victim) {
+    writeback_pages_[victim_page_id] = frame_id;
+  }
+  if (victim_page_id != INVALID_PAGE_ID) {
+    evictions_++;
+    Trace(victim_page_id, AccessType::EVICT);
+  }
+  PublishFrame(frame_id, page_id, record_access);
+  latch->unlock();
+
+  if (write_back) {
+    MarkClean(p);
+    disk_manager_->WritePage(victim_page_id, p->data_);
+    writebacks_++;
+  }
+  if (cache_victim) {
+    compressed_cache_->Insert(victim_page_id, p->data_);
+  }
+  p->ResetMemory();
+  if (read_page) {
+    ReadPageData(page_id, p->data_);
+  }
+  if (write_back || cache_victim) {
+    std::unique_lock writeback_latch = AcquireLatch();
+    writeback_pages_.erase(victim_page_id);
+  }
+  p->version_.fetch_add(1);
+  FinishIo(p);
+  return p;
+}
+
+BufferPoolStats BufferPoolManagerInstance::GetStatsImp() {
+  BufferPoolStats stats;
+  for (const auto &counter : hit_counters_) {
+    stats.hits_ += counter.hits_;
+  }
+  stats.misses_ = misses_;
+  stats.evictions_ = evictions_;
+  stats.writebacks_ = writebacks_;
+  stats.flushes_ = flushes_;
+  stats.pin_failures_ = pin_failures_;
+  stats.latch_wait_ns_ = latch_wait_ns_;
+  if (compressed_cache_ != nullptr) {
+    stats.compressed_hits_ = compressed_cache_->GetHits();
+    stats.compressed_misses_ = compressed_cache_->GetMisses();
+  }
+  return stats;
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::AcquireLatch() {
+  std::unique_lock latch(latch_, std::try_to_lock);
+  if (!latch.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    latch_waiters_++;
+    latch.lock();
+    latch_waiters_--;
+    latch_wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                          .count();
+  }
+  return latch;
+}
+
+void BufferPoolManagerInstance::ReadPageData(page_id_t page_id, char *page_data) {
+  if (compressed_cache_ == nullptr || !compressed_cache_->Take(page_id, page_data)) {
+    disk_manager_->ReadPage(page_id, page_data);
+  }
+}
+
+void BufferPoolManagerInstance::WaitForIo(Page *page) {
+  if (!page->io_in_progress_) {
+    return;
+  }
+  std::unique_lock io_latch(page->io_latch_);
+  page->io_cv_.wait(io_latch, [page] { return !page->io_in_progress_; });
+}
+
+void BufferPoolManagerInstance::FinishIo(Page *page) {
+  {
+    std::scoped_lock io_latch(page->io_latch_);
+    page->io_in_progress_ = false;
+  }
+  page->io_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::MarkDirty(Page *page) {
+  if (!page->is_dirty_.exchange(true) && ++num_dirty_ > writer_high_pages_ && writer_running_) {
+    KickBackgroundWriter();
+  }
+}
+
+void BufferPoolManagerInstance::MarkClean(Page *page) {
+  if (page->is_dirty_.exchange(false)) {
+    num_dirty_--;
+  }
+}
+
+void BufferPoolManagerInstance::StartBackgroundWriter(double low_watermark, double high_watermark,
+                                                      std::chrono::milliseconds interval) {
+  BUSTUB_ASSERT(0 <= low_watermark && low_watermark <= high_watermark && high_watermark <= 1,
+                "Watermarks must satisfy 0 <= low <= high <= 1.");
+  StopBackgroundWriter();
+  writer_low_watermark_ = low_watermark;
+  writer_high_watermark_ = high_watermark;
+  writer_low_pages_ = static_cast<size_t>(low_watermark * pool_size_);
+  writer_high_pages_ = static_cast<size_t>(high_watermark * pool_size_);
+  writer_interval_ = interval;
+  writer_kicked_ = false;
+  writer_running_ = true;
+  writer_ = std::thread(&BufferPoolManagerInstance::RunBackgroundWriter, this);
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock writer_latch(writer_latch_);
+    writer_running_ = false;
+  }
+  writer_cv_.notify_one();
+  writer_.join();
+}
+
+void BufferPoolManagerInstance::KickBackgroundWriter() {
+  // A kick that races with the writer going to sleep is only noticed at the end of its interval, which is fine.
+  if (!writer_kicked_.exchange(true)) {
+    writer_cv_.notify_one();
+  }
+}
+
+void BufferPoolManagerInstance::RunBackgroundWriter() {
+  std::unique_lock writer_latch(writer_latch_);
+  while (writer_running_) {
+    writer_cv_.wait_for(writer_latch, writer_interval_, [this] { return !writer_running_ || writer_kicked_; });
+    writer_kicked_ = false;
+    if (!writer_running_) {
+      break;
+    }
+    writer_latch.unlock();
+    CleanDirtyPages(writer_low_pages_);
+    writer_latch.lock();
+  }
+}
+
+void BufferPoolManagerInstance::CleanDirtyPages(size_t target) {
+  if (num_dirty_ <= target) {
+    return;
+  }
+  std::vector<std::pair<page_id_t, frame_id_t>> candidates;
+  page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+    Page *p = &pages_[frame_id];
+    if (p->IsDirty() && p->GetPinCount() == 0) {
+      candidates.emplace_back(page_id, frame_id);
+    }
+  });
+  for (const auto &[page_id, frame_id] : candidates) {
+    if (num_dirty_ <= target || !writer_running_) {
+      break;
+    }
+    WriteBackUnpinned(page_id, frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::WriteBackUnpinned(page_id_t page_id, frame_id_t frame_id) {
+  Page *p = &pages_[frame_id];
+  // The shard latch is not held across the write: hits keep pinning the page, and only eviction and deletion wait for
+  // the claim to be released.
+  if (p->GetPinCount() != 0) {
+    return;
+  }
+  bool writing;
+  if (!ClaimWriteback(page_id, frame_id, &writing)) {
+    return;
+  }
+  MarkClean(p);
+  disk_manager_->WritePage(page_id, p->data_);
+  flushes_++;
+  FinishWriteback(p);
+}
+
+bool BufferPoolManagerInstance::ClaimWriteback(page_id_t page_id, frame_id_t frame_id, bool *writing) {
+  Page *p = &pages_[frame_id];
+  bool claimed = false;
+  *writing = false;
+  // claim the frame while its shard is latched, so that it cannot be evicted between the check and the claim
+  page_table_.Find(page_id, [&](frame_id_t resident_frame_id) {
+    if (resident_frame_id != frame_id || !p->IsDirty() || p->io_in_progress_) {
+      return;
+    }
+    *writing = p->writeback_in_progress_.exchange(true);
+    claimed = !*writing;
+  });
+  return claimed;
+}
+
+void BufferPoolManagerInstance::FinishWriteback(Page *page) {
+  {
+    std::scoped_lock io_latch(page->io_latch_);
+    page->writeback_in_progress_ = false;
+  }
+  page->io_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::WaitForWriteback(Page *page) {
+  std::unique_lock io_latch(page->io_latch_);
+  page->io_cv_.wait(io_latch, [page] { return !page->writeback_in_progress_; });
+}
+
+void BufferPoolManagerInstance::PrefetchPgsImp(const std::vector<page_id_t> &page_ids,
+                                               const prefetch_callback_fn &on_loaded) {
+  std::scoped_lock prefetch_latch(prefetch_latch_);
+  if (prefetch_stopped_) {
+    return;
+  }
+  if (prefetchers_.empty()) {
+    for (int i = 0; i < PREFETCH_WORKERS; i++) {
+      prefetchers_.emplace_back(&BufferPoolManagerInstance::RunPrefetcher, this);
+    }
+  }
+  for (page_id_t page_id : page_ids) {
+    ValidatePageId(page_id);
+    // more outstanding reads than frames would only evict pages that were prefetched earlier
+    if (prefetch_queue_.size() >= pool_size_) {
+      break;
+    }
+    prefetch_queue_.emplace_back(page_id, on_loaded);
+  }
+  prefetch_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::StopPrefetching() {
+  std::vector<std::thread> prefetchers;
+  {
+    std::scoped_lock prefetch_latch(prefetch_latch_);
+    prefetch_stopped_ = true;
+    prefetch_queue_.clear();
+    prefetchers.swap(prefetchers_);
+  }
+  prefetch_cv_.notify_all();
+  for (auto &prefetcher : prefetchers) {
+    prefetcher.join();
+  }
+}
+
+void BufferPoolManagerInstance::RunPrefetcher() {
+  std::unique_lock prefetch_latch(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(prefetch_latch, [this] { return prefetch_stopped_ || !prefetch_queue_.empty(); });
+    if (prefetch_stopped_) {
+      return;
+    }
+    auto [page_id, on_loaded] = std::move(prefetch_queue_.front());
+    prefetch_queue_.pop_front();
+    prefetch_latch.unlock();
+    PrefetchPage(page_id, on_loaded);
+    prefetch_latch.lock();
+  }
+}
+
+void BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, const prefetch_callback_fn &on_loaded) {
+  frame_id_t frame_id;
+  if (!on_loaded && page_table_.Find(page_id, &frame_id)) {
+    return;
+  }
+  // The page is pinned only while it is read in and handed to the callback. A prefetch is not an access, so the first
+  // real fetch of the page counts as its first use in the replacer's history.
+  Page *p = FetchFrame(page_id, false);
+  if (p == nullptr) {
+    return;
+  }
+  if (on_loaded) {
+    on_loaded(p);
+  }
+  UnpinPgImp(page_id, false);
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetHotSetImp() {
+  std::unordered_map<frame_id_t, page_id_t> resident;
+  page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) { resident.emplace(frame_id, page_id); });
+  // The page table and the replacer are read one after the other, so the snapshot can be slightly off under
+  // concurrent traffic. It is only a hint for the next warm-up.
+  std::vector<page_id_t> hot_set;
+  hot_set.reserve(resident.size());
+  for (frame_id_t frame_id : replacer_->EvictionOrder()) {
+    auto it = resident.find(frame_id);
+    if (it != resident.end()) {
+      hot_set.push_back(it->second);
+      resident.erase(it);
+    }
+  }
+  // what is left is pinned, or the replacer cannot tell its order
+  for (const auto &[frame_id, page_id] : resident) {
+    hot_set.push_back(page_id);
+  }
+  return hot_set;
+}
+
+void BufferPoolManagerInstance::WarmUpImp(const std::vector<page_id_t> &hot_set) {
+  for (page_id_t page_id : hot_set) {
+    ValidatePageId(page_id);
+  }
+  // only the hottest pages that fit in the pool are worth reading
+  const size_t skip = hot_set.size() > pool_size_ ? hot_set.size() - pool_size_ : 0;
+  std::vector<page_id_t> hottest(hot_set.begin() + skip, hot_set.end());
+  std::scoped_lock prefetch_latch(prefetch_latch_);
+  if (prefetch_stopped_ || hottest.empty()) {
+    return;
+  }
+  prefetchers_.emplace_back(&BufferPoolManagerInstance::RunWarmUp, this, std::move(hottest));
+}
+
+void BufferPoolManagerInstance::RunWarmUp(std::vector<page_id_t> hot_set) {
+  std::vector<page_id_t> sorted = hot_set;
+  std::sort(sorted.begin(), sorted.end());
+  for (size_t begin = 0; begin < sorted.size(); begin += WARMUP_BATCH_SIZE) {
+    {
+      std::scoped_lock prefetch_latch(prefetch_latch_);
+      if (prefetch_stopped_) {
+        return;
+      }
+    }
+    const size_t end = std::min(sorted.size(), begin + WARMUP_BATCH_SIZE);
+    if (!WarmUpBatch(std::vector<page_id_t>(sorted.begin() + begin, sorted.begin() + end))) {
+      break;
+    }
+  }
+  // The pages entered the replacer in page id order. Put the ones nobody has fetched yet back in the order they were
+  // saved in; a page that was fetched meanwhile already has a real place in the replacer.
+  for (page_id_t page_id : hot_set) {
+    page_table_.Find(page_id, [&](frame_id_t frame_id) {
+      Page *p = &pages_[frame_id];
+      if (p->GetPinCount() == 0 && !p->fetched_) {
+        replacer_->Remove(frame_id);
+        replacer_->Unpin(frame_id);
+      }
+    });
+  }
+}
+
+bool BufferPoolManagerInstance::WarmUpBatch(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> loading;
+  bool frames_left = true;
+  {
+    std::scoped_lock latch(latch_);
+    for (page_id_t page_id : page_ids) {
+      if (free_list_.empty()) {
+        frames_left = false;
+        break;
+      }
+      // a hot set may name pages that were deleted since it was saved, and those must not be read back in
+      frame_id_t frame_id;
+      if (page_table_.Find(page_id, &frame_id) || writeback_pages_.count(page_id) > 0 ||
+          !disk_manager_->IsPageAllocated(page_id)) {
+        continue;
+      }
+      frame_id = free_list_.front();
+      free_list_.pop_front();
+      num_free_frames_ = free_list_.size();
+      PublishFrame(frame_id, page_id, false);
+      loading.push_back(&pages_[frame_id]);
+    }
+  }
+  // Read the whole batch with one submission, so the disk sees all of it at once.
+  std::vector<DiskRequest> requests;
+  std::vector<std::pair<Page *, std::future<bool>>> reads;
+  for (Page *p : loading) {
+    p->ResetMemory();
+    if (compressed_cache_ != nullptr && compressed_cache_->Take(p->page_id_, p->data_)) {
+      FinishWarmUpRead(p);
+      continue;
+    }
+    requests.push_back(DiskRequest{false, p->data_, p->page_id_, {}});
+    reads.emplace_back(p, requests.back().callback_.get_future());
+  }
+  disk_manager_->SubmitBatch(&requests);
+  for (auto &[p, read] : reads) {
+    read.wait();
+    FinishWarmUpRead(p);
+  }
+  return frames_left;
+}
+
+void BufferPoolManagerInstance::FinishWarmUpRead(Page *p) {
+  const page_id_t page_id = p->page_id_;
+  p->version_.fetch_add(1);
+  FinishIo(p);
+  UnpinPgImp(page_id, false);
+}
+
 size_t BufferPoolManagerInstance::GetOccupiedPageNum() {
-  LOG_DEBUG("1:%ld\t2:%ld\n", page_table_.size(), replacer_->Size());
-  return page_table_.size() - replacer_->Size();
+  LOG_DEBUG("1:%ld\t2:%ld\n", page_table_.Size(), replacer_->Size());
+  return page_table_.Size() - replacer_->Size();
 }
 
 void BufferPoolManagerInstance::PrintExistPageId() {
-  for (auto item : page_table_) {
-    printf("page id is:%d pin count is %d\n", item.first, pages_[item.second].pin_count_);
-  }
+  page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+    printf("page id is:%d pin count is %d\n", page_id, pages_[frame_id].GetPinCount());
+  });
 }
 
 }  // namespace bustub
@@ -12,18 +12,89 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <algorithm>
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages), frames_(new FrameState[num_pages]) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  return PreferredVictim(frame_id, [](frame_id_t) { return true; });
+}
+
+bool ClockReplacer::PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) {
+  std::scoped_lock latch(hand_latch_);
+  // The first sweep clears every reference bit it passes, so the second sweep finds a victim unless concurrent
+  // Pin/Unpin calls keep changing the picture underneath us; give up after that rather than spin.
+  frame_id_t fallback = INVALID_PAGE_ID;
+  for (size_t step = 0; step < 2 * num_pages_ && size_.load() > 0; step++) {
+    FrameState &frame = frames_[hand_];
+    auto current = static_cast<frame_id_t>(hand_);
+    hand_ = (hand_ + 1) % num_pages_;
+    if (!frame.evictable_.load()) {
+      continue;
+    }
+    if (frame.referenced_.exchange(false)) {
+      continue;
+    }
+    if (!preferred(current)) {
+      if (fallback == INVALID_PAGE_ID) {
+        fallback = current;
+      }
+      continue;
+    }
+    if (Claim(current)) {
+      *frame_id = current;
+      return true;
+    }
+  }
+  if (fallback != INVALID_PAGE_ID && Claim(fallback)) {
+    *frame_id = fallback;
+    return true;
+  }
+  return false;
+}
+
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if (frames_[frame_id].evictable_.exchange(false)) {
+    size_--;
+  }
+}
+
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  FrameState &frame = frames_[frame_id];
+  frame.referenced_.store(true);
+  if (!frame.evictable_.exchange(true)) {
+    size_++;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+std::vector<frame_id_t> ClockReplacer::EvictionOrder() {
+  std::scoped_lock latch(hand_latch_);
+  std::vector<frame_id_t> order;
+  std::vector<frame_id_t> referenced;
+  for (size_t step = 0; step < num_pages_; step++) {
+    auto current = static_cast<frame_id_t>((hand_ + step) % num_pages_);
+    const FrameState &frame = frames_[current];
+    if (frame.evictable_.load()) {
+      (frame.referenced_.load() ? referenced : order).push_back(current);
+    }
+  }
+  order.insert(order.end(), referenced.begin(), referenced.end());
+  return order;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+bool ClockReplacer::Claim(frame_id_t frame_id) {
+  bool evictable = true;
+  if (frames_[frame_id].evictable_.compare_exchange_strong(evictable, false)) {
+    size_--;
+    return true;
+  }
+  return false;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() { return static_cast<size_t>(std::max<int64_t>(size_.load(), 0)); }
 
 }  // namespace bustub
@@ -0,0 +1,184 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+// A compressed page is a sequence of tokens. A control byte below 0x80 is followed by (byte + 1) literal bytes; any
+// other control byte is a match of ((byte & 0x7F) + MIN_MATCH) bytes, copied from a two-byte little endian distance
+// back in the output. Matches may overlap their own output, so a run of equal bytes costs one literal and one match.
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_MATCH = 0x7F + MIN_MATCH;
+static constexpr size_t MAX_LITERALS = 0x80;
+static constexpr int HASH_BITS = 12;
+static_assert(PAGE_SIZE <= 0x10000, "match distances must fit into two bytes");
+
+CompressedPageCache::CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *page_data) {
+  std::vector<char> data;
+  const bool compressed = Compress(page_data, &data);
+  if (!compressed) {
+    data.assign(page_data, page_data + PAGE_SIZE);
+  }
+  std::scoped_lock latch(latch_);
+  auto old = entries_.find(page_id);
+  if (old != entries_.end()) {
+    EraseEntry(old);
+  }
+  if (data.size() > capacity_) {
+    return;
+  }
+  while (used_bytes_ + data.size() > capacity_) {
+    EraseEntry(entries_.find(lru_list_.back()));
+  }
+  used_bytes_ += data.size();
+  lru_list_.push_front(page_id);
+  entries_.emplace(page_id, Entry{lru_list_.begin(), std::move(data), compressed});
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *page_data) {
+  std::vector<char> data;
+  bool compressed;
+  {
+    std::scoped_lock latch(latch_);
+    auto entry = entries_.find(page_id);
+    if (entry == entries_.end()) {
+      misses_++;
+      return false;
+    }
+    hits_++;
+    data = std::move(entry->second.data_);
+    compressed = entry->second.compressed_;
+    used_bytes_ -= data.size();
+    lru_list_.erase(entry->second.position_);
+    entries_.erase(entry);
+  }
+  if (compressed) {
+    Decompress(data, page_data);
+  } else {
+    memcpy(page_data, data.data(), PAGE_SIZE);
+  }
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock latch(latch_);
+  auto entry = entries_.find(page_id);
+  if (entry != entries_.end()) {
+    EraseEntry(entry);
+  }
+}
+
+void CompressedPageCache::EraseEntry(std::unordered_map<page_id_t, Entry>::iterator entry) {
+  used_bytes_ -= entry->second.data_.size();
+  lru_list_.erase(entry->second.position_);
+  entries_.erase(entry);
+}
+
+size_t CompressedPageCache::GetHits() {
+  std::scoped_lock latch(latch_);
+  return hits_;
+}
+
+size_t CompressedPageCache::GetMisses() {
+  std::scoped_lock latch(latch_);
+  return misses_;
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::scoped_lock latch(latch_);
+  return entries_.size();
+}
+
+size_t CompressedPageCache::GetUsedBytes() {
+  std::scoped_lock latch(latch_);
+  return used_bytes_;
+}
+
+bool CompressedPageCache::Compress(const char *page_data, std::vector<char> *compressed) {
+  const auto *src = reinterpret_cast<const uint8_t *>(page_data);
+  compressed->clear();
+  compressed->reserve(PAGE_SIZE);
+  // the most recent position of every hashed 4-byte sequence
+  std::array<int, 1 << HASH_BITS> last_seen;
+  last_seen.fill(-1);
+  size_t literal_start = 0;
+  auto emit_literals = [&](size_t end) {
+    while (literal_start < end) {
+      size_t count = std::min(end - literal_start, MAX_LITERALS);
+      compressed->push_back(static_cast<char>(count - 1));
+      compressed->insert(compressed->end(), page_data + literal_start, page_data + literal_start + count);
+      literal_start += count;
+    }
+  };
+
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= PAGE_SIZE && compressed->size() < PAGE_SIZE) {
+    uint32_t sequence;
+    memcpy(&sequence, src + pos, sizeof(sequence));
+    const uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    const int candidate = last_seen[hash];
+    last_seen[hash] = static_cast<int>(pos);
+    if (candidate < 0 || memcmp(src + candidate, src + pos, MIN_MATCH) != 0) {
+      pos++;
+      continue;
+    }
+    size_t length = MIN_MATCH;
+    while (pos + length < PAGE_SIZE && length < MAX_MATCH && src[candidate + length] == src[pos + length]) {
+      length++;
+    }
+    emit_literals(pos);
+    const size_t distance = pos - candidate;
+    compressed->push_back(static_cast<char>(0x80 | (length - MIN_MATCH)));
+    compressed->push_back(static_cast<char>(distance & 0xFF));
+    compressed->push_back(static_cast<char>(distance >> 8));
+    pos += length;
+    literal_start = pos;
+  }
+  emit_literals(PAGE_SIZE);
+  return compressed->size() < PAGE_SIZE;
+}
+
+void CompressedPageCache::Decompress(const std::vector<char> &compressed, char *page_data) {
+  const auto *src = reinterpret_cast<const uint8_t *>(compressed.data());
+  size_t in = 0;
+  size_t out = 0;
+  while (in < compressed.size()) {
+    const uint8_t control = src[in++];
+    if (control < MAX_LITERALS) {
+      const size_t count = control + 1;
+      memcpy(page_data + out, src + in, count);
+      in += count;
+      out += count;
+      continue;
+    }
+    const size_t length = (control & 0x7F) + MIN_MATCH;
+    const size_t distance = src[in] | (src[in + 1] << 8);
+    in += 2;
+    // byte by byte, since the match may overlap the bytes it produces
+    for (size_t i = 0; i < length; i++, out++) {
+      page_data[out] = page_data[out - distance];
+    }
+  }
+  BUSTUB_ASSERT(out == PAGE_SIZE, "a compressed page must decompress to exactly one page");
+}
+
+}  // namespace bustub
@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period)
+    : k_(k), correlated_period_(correlated_period), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to track at least one access per frame.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::scoped_lock latch(latch_);
+  if (evictable_.empty()) {
+    return false;
+  }
+  // prefer the first frame in eviction order that is outside its correlated reference period
+  auto victim = evictable_.begin();
+  for (auto it = evictable_.begin(); it != evictable_.end(); ++it) {
+    if (Uncorrelated(std::get<2>(*it))) {
+      victim = it;
+      break;
+    }
+  }
+  Evict(victim, frame_id);
+  return true;
+}
+
+bool LRUKReplacer::PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) {
+  std::scoped_lock latch(latch_);
+  if (evictable_.empty()) {
+    return false;
+  }
+  // Rank candidates: preferred and uncorrelated, then uncorrelated, then preferred, then whatever comes first.
+  auto victim = evictable_.end();
+  int best_rank = -1;
+  for (auto it = evictable_.begin(); it != evictable_.end() && best_rank < 3; ++it) {
+    int rank = (Uncorrelated(std::get<2>(*it)) ? 2 : 0) + (preferred(std::get<2>(*it)) ? 1 : 0);
+    if (rank > best_rank) {
+      victim = it;
+      best_rank = rank;
+    }
+  }
+  Evict(victim, frame_id);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock latch(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(KeyOf(frame_id));
+    frame.evictable_ = false;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock latch(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  // A frame that was never accessed through RecordAccess (e.g. a prefetched page) is ordered by the time it was
+  // unpinned. That timestamp is only a placeholder and is replaced by the first real access.
+  if (frame.history_.empty()) {
+    Access(&frame);
+    frame.unreferenced_ = true;
+  }
+  frame.evictable_ = true;
+  evictable_.insert(KeyOf(frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock latch(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(KeyOf(frame_id));
+    frame.evictable_ = false;
+  }
+  frame.history_.clear();
+  frame.unreferenced_ = false;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::scoped_lock latch(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    evictable_.erase(KeyOf(frame_id));
+    Access(&frame);
+    evictable_.insert(KeyOf(frame_id));
+  } else {
+    Access(&frame);
+  }
+}
+
+std::vector<frame_id_t> LRUKReplacer::EvictionOrder() {
+  std::scoped_lock latch(latch_);
+  // Victim takes frames outside their correlated reference period first.
+  std::vector<frame_id_t> order;
+  std::vector<frame_id_t> correlated;
+  for (const auto &key : evictable_) {
+    frame_id_t frame_id = std::get<2>(key);
+    (Uncorrelated(frame_id) ? order : correlated).push_back(frame_id);
+  }
+  order.insert(order.end(), correlated.begin(), correlated.end());
+  return order;
+}
+
+size_t LRUKReplacer::Size() {
+  std::scoped_lock latch(latch_);
+  return evictable_.size();
+}
+
+void LRUKReplacer::Access(FrameHistory *frame) {
+  current_timestamp_++;
+  if (frame->unreferenced_) {
+    frame->history_.clear();
+    frame->unreferenced_ = false;
+  }
+  if (!frame->history_.empty() && current_timestamp_ - frame->last_access_ <= correlated_period_) {
+    frame->last_access_ = current_timestamp_;
+    return;
+  }
+  frame->history_.push_back(current_timestamp_);
+  if (frame->history_.size() > k_) {
+    frame->history_.erase(frame->history_.begin());
+  }
+  frame->last_access_ = current_timestamp_;
+}
+
+bool LRUKReplacer::Uncorrelated(frame_id_t frame_id) const {
+  // the frame is still correlated if Access would collapse the next access into its last one
+  return current_timestamp_ - frames_[frame_id].last_access_ >= correlated_period_;
+}
+
+void LRUKReplacer::Evict(std::set<EvictionKey>::iterator victim, frame_id_t *frame_id) {
+  *frame_id = std::get<2>(*victim);
+  evictable_.erase(victim);
+  frames_[*frame_id].history_.clear();
+  frames_[*frame_id].unreferenced_ = false;
+  frames_[*frame_id].evictable_ = false;
+}
+
+LRUKReplacer::EvictionKey LRUKReplacer::KeyOf(frame_id_t frame_id) const {
+  // With fewer than K accesses the front is the first access, otherwise it is the K-th most recent one.
+  const FrameHistory &frame = frames_[frame_id];
+  return {frame.history_.size() >= k_, frame.history_.front(), frame_id};
+}
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #include "buffer/lru_replacer.h"
 
+#include <iterator>
+
 namespace bustub {
 // 被锁定了不能置换，就不能放进list
 // 被启用了，那就从list删除
@@ -40,6 +42,24 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
   return false;
 }
 
+bool LRUReplacer::PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) {
+  std::scoped_lock latch(lru_mutex_);
+  if (lru_list_.empty()) {
+    return false;
+  }
+  auto victim = std::prev(lru_list_.end());
+  for (auto it = lru_list_.rbegin(); it != lru_list_.rend(); ++it) {
+    if (preferred(*it)) {
+      victim = std::prev(it.base());
+      break;
+    }
+  }
+  *frame_id = *victim;
+  lru_list_.erase(victim);
+  lru_vec_[*frame_id] = lru_list_.end();
+  return true;
+}
+
 void LRUReplacer::Pin(frame_id_t frame_id) {
   lru_mutex_.lock();
   if (lru_vec_[frame_id] != lru_list_.end()) {
@@ -58,6 +78,11 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   lru_mutex_.unlock();
 }
 
+std::vector<frame_id_t> LRUReplacer::EvictionOrder() {
+  std::scoped_lock latch(lru_mutex_);
+  return std::vector<frame_id_t>(lru_list_.rbegin(), lru_list_.rend());
+}
+
 size_t LRUReplacer::Size() {
   lru_mutex_.lock();
   size_t size = lru_list_.size();
@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+namespace {
+uint32_t ShardShift(size_t num_shards) {
+  uint32_t shift = 32;
+  while (num_shards > 1) {
+    num_shards >>= 1;
+    shift--;
+  }
+  return shift;
+}
+}  // namespace
+
+PageTable::PageTable(size_t num_shards)
+    : num_shards_(num_shards), shard_shift_(ShardShift(num_shards)), shards_(new Shard[num_shards]) {
+  BUSTUB_ASSERT(num_shards > 0 && (num_shards & (num_shards - 1)) == 0, "Shard count must be a power of two.");
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) {
+  return Find(page_id, [frame_id](frame_id_t found) { *frame_id = found; });
+}
+
+bool PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  Shard &shard = GetShard(page_id);
+  std::unique_lock latch(shard.latch_);
+  if (!shard.map_.emplace(page_id, frame_id).second) {
+    return false;
+  }
+  size_++;
+  return true;
+}
+
+}  // namespace bustub
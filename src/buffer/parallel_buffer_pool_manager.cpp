@@ -15,18 +15,23 @@
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : num_instances_(num_instances) {
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size, size_t compressed_cache_size)
+    : disk_manager_(disk_manager), num_instances_(num_instances) {
   // Allocate and create individual BufferPoolManagerInstances
-  start_index_ = 0;
   pool_size_ = pool_size * num_instances;
   for (int i = 0; i != static_cast<int>(num_instances_); i++) {
-    bpis_.emplace_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager));
+    bpis_.emplace_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, log_manager,
+                                                     replacer_type, max_pool_size, compressed_cache_size));
   }
 }
 
 // Update constructor to destruct all BufferPoolManagerInstances and deallocate any associated memory
 ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // a prefetch callback running in one instance may still hand hints to another one
+  for (auto *bpi : bpis_) {
+    bpi->StopPrefetching();
+  }
   for (int i = 0; i != static_cast<int>(num_instances_); i++) {
     delete bpis_[i];
   }
@@ -37,6 +42,19 @@ size_t ParallelBufferPoolManager::GetPoolSize() {
   return pool_size_;
 }
 
+void ParallelBufferPoolManager::StartBackgroundWriter(double low_watermark, double high_watermark,
+                                                      std::chrono::milliseconds interval) {
+  for (auto *bpi : bpis_) {
+    bpi->StartBackgroundWriter(low_watermark, high_watermark, interval);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *bpi : bpis_) {
+    bpi->StopBackgroundWriter();
+  }
+}
+
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   page_id_t target_id = page_id % num_instances_;
@@ -50,6 +68,40 @@ Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
   return p;
 }
 
+Page *ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // The retired page may belong to another instance, so it is left in the strategy for our caller to route.
+  return bpis_[page_id % num_instances_]->FetchPgWithStrategyImp(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::RetirePgImp(page_id_t page_id) {
+  bpis_[page_id % num_instances_]->RetirePgImp(page_id);
+}
+
+bool ParallelBufferPoolManager::ResizePoolImp(size_t pool_size) {
+  if (pool_size < num_instances_) {
+    return false;
+  }
+  bool resized = true;
+  size_t new_pool_size = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    // the first pool_size % num_instances_ instances take one frame of the remainder each
+    size_t instance_pool_size = pool_size / num_instances_ + (i < pool_size % num_instances_ ? 1 : 0);
+    resized = bpis_[i]->ResizePool(instance_pool_size) && resized;
+    new_pool_size += bpis_[i]->GetPoolSize();
+  }
+  pool_size_ = new_pool_size;
+  return resized;
+}
+
+Page *ParallelBufferPoolManager::PeekPgImp(page_id_t page_id) {
+  BufferPoolManager *bpm = GetBufferPoolManager(page_id);
+  return bpm->PeekPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::FetchResidentPgImp(page_id_t page_id) {
+  return bpis_[page_id % num_instances_]->FetchResidentPgImp(page_id);
+}
+
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   // Unpin page_id from responsible BufferPoolManagerInstance
   BufferPoolManager *bpm = GetBufferPoolManager(page_id);
@@ -65,25 +117,27 @@ bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
 }
 
 Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
-  int start = start_index_;
-  Page *p = nullptr;
-  do {
-    BufferPoolManager *bpm = GetBufferPoolManager(static_cast<page_id_t>(start));
-    p = bpm->NewPage(page_id);
+  // Round robin alone spreads the pages evenly, but keeps handing pages to an instance that is full of pinned pages or
+  // busy; the second choice steers around it without looking at every instance.
+  const size_t ticket = next_instance_.fetch_add(1, std::memory_order_relaxed);
+  size_t start = ticket % num_instances_;
+  if (num_instances_ > 1) {
+    const size_t offset = ((ticket * 0x9E3779B97F4A7C15ULL) >> 32) % (num_instances_ - 1) + 1;
+    const size_t other = (start + offset) % num_instances_;
+    const size_t start_free = bpis_[start]->GetFreeFrameNum();
+    const size_t other_free = bpis_[other]->GetFreeFrameNum();
+    if (other_free > start_free ||
+        (other_free == start_free && bpis_[other]->GetLatchWaiterNum() < bpis_[start]->GetLatchWaiterNum())) {
+      start = other;
+    }
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    Page *p = bpis_[(start + i) % num_instances_]->NewPage(page_id);
     if (p != nullptr) {
-      break;
+      return p;
     }
-    start = static_cast<int>((start + 1) % num_instances_);
-    /* code */
-  } while (start != start_index_);
-
-  return p;
+  }
+  return nullptr;
 }
 
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
@@ -93,11 +147,67 @@ bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
   return flag;
 }
 
+std::shared_ptr<Extent> ParallelBufferPoolManager::AllocateExtentImp(size_t num_pages) {
+  return bpis_[0]->AllocateExtentImp(num_pages);
+}
+
+Page *ParallelBufferPoolManager::NewPgWithIdImp(page_id_t page_id) {
+  return bpis_[page_id % num_instances_]->NewPgWithIdImp(page_id);
+}
+
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
-  for (int i = 0; i != static_cast<int>(num_instances_); i++) {
-    BufferPoolManager *bpm = bpis_[i];
-    bpm->FlushAllPages();
+  // flush all pages from all BufferPoolManagerInstances, then sync the file they share once
+  for (auto *bpi : bpis_) {
+    bpi->WriteAllDirtyPages();
+  }
+  disk_manager_->Sync();
+}
+
+void ParallelBufferPoolManager::PrefetchPgsImp(const std::vector<page_id_t> &page_ids,
+                                               const prefetch_callback_fn &on_loaded) {
+  std::vector<std::vector<page_id_t>> per_instance(num_instances_);
+  for (page_id_t page_id : page_ids) {
+    per_instance[page_id % num_instances_].push_back(page_id);
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    if (!per_instance[i].empty()) {
+      bpis_[i]->PrefetchPages(per_instance[i], on_loaded);
+    }
+  }
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetHotSetImp() {
+  std::vector<page_id_t> hot_set;
+  for (auto *bpi : bpis_) {
+    std::vector<page_id_t> instance_hot_set = bpi->GetHotSet();
+    hot_set.insert(hot_set.end(), instance_hot_set.begin(), instance_hot_set.end());
+  }
+  return hot_set;
+}
+
+void ParallelBufferPoolManager::WarmUpImp(const std::vector<page_id_t> &hot_set) {
+  std::vector<std::vector<page_id_t>> per_instance(num_instances_);
+  for (page_id_t page_id : hot_set) {
+    per_instance[page_id % num_instances_].push_back(page_id);
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    if (!per_instance[i].empty()) {
+      bpis_[i]->WarmUp(per_instance[i]);
+    }
+  }
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStatsImp() {
+  BufferPoolStats stats;
+  for (auto *bpi : bpis_) {
+    stats += bpi->GetStats();
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::SetAccessTraceImp(AccessTrace *trace) {
+  for (auto *bpi : bpis_) {
+    bpi->SetAccessTrace(trace);
   }
 }
 
@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_simulator.cpp
+//
+// Identification: src/buffer/replacer_simulator.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer_simulator.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+
+#include "buffer/access_trace.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+double ReplacerSimulator::Result::HitRatio() const {
+  const uint64_t references = hits_ + misses_;
+  return references == 0 ? 0 : static_cast<double>(hits_) / references;
+}
+
+double ReplacerSimulator::Result::NsPerReference() const {
+  const uint64_t references = hits_ + misses_;
+  return references == 0 ? 0 : static_cast<double>(elapsed_ns_) / references;
+}
+
+ReplacerSimulator::ReplacerFactory ReplacerSimulator::FactoryFor(ReplacerType type) {
+  switch (type) {
+    case ReplacerType::LRU:
+      return [](size_t num_frames) { return std::make_unique<LRUReplacer>(num_frames); };
+    case ReplacerType::LRUK:
+      return [](size_t num_frames) {
+        return std::make_unique<LRUKReplacer>(num_frames, LRUK_REPLACER_K, LRUK_CORRELATED_PERIOD);
+      };
+    case ReplacerType::CLOCK:
+      return [](size_t num_frames) { return std::make_unique<ClockReplacer>(num_frames); };
+  }
+  UNREACHABLE("unknown replacer type");
+}
+
+ReplacerSimulator::Result ReplacerSimulator::Replay(const ReplacerFactory &factory, size_t pool_size,
+                                                    const std::vector<page_id_t> &references) {
+  BUSTUB_ASSERT(pool_size > 0, "A simulated pool needs at least one frame.");
+  std::unique_ptr<Replacer> replacer = factory(pool_size);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  page_table.reserve(pool_size);
+  std::vector<page_id_t> frame_pages(pool_size, INVALID_PAGE_ID);
+  auto next_free = static_cast<frame_id_t>(0);
+
+  Result result;
+  const auto start = std::chrono::steady_clock::now();
+  for (page_id_t page_id : references) {
+    auto entry = page_table.find(page_id);
+    if (entry != page_table.end()) {
+      result.hits_++;
+      replacer->RecordAccess(entry->second);
+      replacer->Pin(entry->second);
+      replacer->Unpin(entry->second);
+      continue;
+    }
+    result.misses_++;
+    frame_id_t frame_id;
+    if (static_cast<size_t>(next_free) < pool_size) {
+      frame_id = next_free++;
+    } else {
+      // every frame is unpinned between references, so there always is a victim
+      [[maybe_unused]] bool found = replacer->Victim(&frame_id);
+      BUSTUB_ASSERT(found, "A replacer holding only unpinned frames must find a victim.");
+      page_table.erase(frame_pages[frame_id]);
+    }
+    frame_pages[frame_id] = page_id;
+    page_table.emplace(page_id, frame_id);
+    replacer->RecordAccess(frame_id);
+    replacer->Unpin(frame_id);
+  }
+  result.elapsed_ns_ =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+namespace {
+
+/** Draws page ids from a Zipfian distribution by inverting its cumulative distribution function. */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(size_t num_pages, double theta) : cdf_(num_pages) {
+    double sum = 0;
+    for (size_t i = 0; i < num_pages; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (double &value : cdf_) {
+      value /= sum;
+    }
+  }
+
+  page_id_t Next(std::mt19937 *rng) {
+    const double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+    return static_cast<page_id_t>(std::min<size_t>(it - cdf_.begin(), cdf_.size() - 1));
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+}  // namespace
+
+std::vector<page_id_t> ReplacerSimulator::ZipfianTrace(size_t num_pages, size_t length, double theta, uint32_t seed) {
+  return ScanMixedTrace(num_pages, length, theta, 0, 0, seed);
+}
+
+std::vector<page_id_t> ReplacerSimulator::ScanMixedTrace(size_t num_pages, size_t length, double theta,
+                                                         double scan_fraction, size_t scan_length, uint32_t seed) {
+  BUSTUB_ASSERT(num_pages > 0, "A trace needs at least one page.");
+  std::mt19937 rng(seed);
+  ZipfianGenerator zipf(num_pages, theta);
+  std::uniform_int_distribution<size_t> scan_start(0, num_pages - 1);
+  // A reference starts a scan with probability p. Then p * scan_length of every p * scan_length + (1 - p) references
+  // belong to scans, which solves to the p below for the requested fraction.
+  double scan_probability = 0;
+  if (scan_length > 0 && scan_fraction > 0) {
+    scan_probability =
+        scan_fraction >= 1 ? 1 : scan_fraction / (scan_length * (1 - scan_fraction) + scan_fraction);
+  }
+  std::bernoulli_distribution starts_scan(scan_probability);
+
+  std::vector<page_id_t> references;
+  references.reserve(length);
+  while (references.size() < length) {
+    if (!starts_scan(rng)) {
+      references.push_back(zipf.Next(&rng));
+      continue;
+    }
+    const size_t first = scan_start(rng);
+    for (size_t i = 0; i < scan_length && references.size() < length; i++) {
+      references.push_back(static_cast<page_id_t>((first + i) % num_pages));
+    }
+  }
+  return references;
+}
+
+bool ReplacerSimulator::LoadTrace(const std::string &file_name, std::vector<page_id_t> *references) {
+  std::ifstream in(file_name);
+  if (!in) {
+    return false;
+  }
+  references->clear();
+  uint64_t time_ns;
+  std::string type;
+  page_id_t page_id;
+  while (in >> time_ns >> type >> page_id) {
+    if (type == AccessTrace::TypeName(AccessType::HIT) || type == AccessTrace::TypeName(AccessType::MISS) ||
+        type == AccessTrace::TypeName(AccessType::NEW)) {
+      references->push_back(page_id);
+    }
+  }
+  return in.eof();
+}
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -27,21 +28,20 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
   //  implement me!
-  Page *page = buffer_pool_manager_->NewPage(&directory_page_id_);
+  BasicPageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_, &segment_);
   // std::ifstream file("/autograder/bustub/test/container/grading_hash_table_test.cpp");
   // std::string str;
   // while (file.good()) {
   //   std::getline(file, str);
   //   std::cout << str << std::endl;
   // }
-  HashTableDirectoryPage *hash_table_directory_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  HashTableDirectoryPage *hash_table_directory_page = dir_guard.AsMut<HashTableDirectoryPage>();
   // hash_table_directory_page->PrintDirectory();
   hash_table_directory_page->SetPageId(directory_page_id_);
   page_id_t bucket_page_id = INVALID_PAGE_ID;
-  buffer_pool_manager_->NewPage(&bucket_page_id, nullptr);
+  BasicPageGuard bucket_guard = buffer_pool_manager_->NewPageGuarded(&bucket_page_id, &segment_);
+  bucket_guard.SetDirty();
   hash_table_directory_page->SetBucketPageId(0, bucket_page_id);
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));
 }
 
 /*****************************************************************************
@@ -72,17 +72,13 @@ page_id_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  Page *page = buffer_pool_manager_->FetchPage(directory_page_id_);
-  HashTableDirectoryPage *hash_table_directory_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
-  return hash_table_directory_page;
+BasicPageGuard HASH_TABLE_TYPE::FetchDirectoryPage() {
+  return buffer_pool_manager_->FetchPageBasic(directory_page_id_);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
-  return hash_table_bucket_page;
+BasicPageGuard HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
+  return buffer_pool_manager_->FetchPageBasic(bucket_page_id);
 }
 
 /*****************************************************************************
@@ -90,23 +86,60 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
+  bool flag;
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+    if (OptimisticGetValue(key, result, &flag)) {
+      return flag;
+    }
+  }
+  // the directory keeps changing under us (or is not in memory), take the table latch
   // first,find the directorypage
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = FetchDirectoryPage();
   // second,find the page id
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  page_id_t bucket_page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());
   // third,find the bucket_page
-  Page *page_bucket = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page_bucket->RLatch();
-  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page_bucket->GetData());
-  bool flag = hash_table_bucket_page->GetValue(key, comparator_, result);
-  page_bucket->RUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
+  ReadPageGuard bucket_guard = buffer_pool_manager_->FetchPageRead(bucket_page_id);
+  flag = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return flag;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::OptimisticGetValue(const KeyType &key, std::vector<ValueType> *result, bool *found) {
+  Page *page_dir = buffer_pool_manager_->PeekPage(directory_page_id_);
+  uint64_t version;
+  if (page_dir == nullptr || !page_dir->OptimisticReadBegin(&version) ||
+      page_dir->GetPageId() != directory_page_id_) {
+    return false;
+  }
+  HashTableDirectoryPage *dir_page = reinterpret_cast<HashTableDirectoryPage *>(page_dir->GetData());
+  // the global depth may be torn, so check the index before following it
+  uint32_t directory_index = KeyToDirectoryIndex(key, dir_page);
+  if (directory_index >= DIRECTORY_ARRAY_SIZE) {
+    return false;
+  }
+  page_id_t bucket_page_id = dir_page->GetBucketPageId(directory_index);
+  if (!page_dir->OptimisticReadValidate(version)) {
+    return false;
+  }
+  // The bucket may have been merged away and deleted since the directory was read. Only a resident bucket is pinned,
+  // so such a page is never read back in.
+  ReadPageGuard bucket_guard = buffer_pool_manager_->FetchResidentPageRead(bucket_page_id);
+  if (!bucket_guard.IsValid()) {
+    return false;
+  }
+  // A split or merge holds the bucket's write latch while it changes the directory, so if the directory has not
+  // changed now that we hold the bucket's read latch, the key still maps to this bucket.
+  if (!page_dir->OptimisticReadValidate(version)) {
+    return false;
+  }
+  *found = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  return true;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -116,32 +149,28 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
   // VerifyIntegrity();
   // first,find the directorypage
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = FetchDirectoryPage();
   // second,find the page id
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  page_id_t bucket_page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());
   // third,find the bucket_page
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
 
   // if is full?
   if (hash_table_bucket_page->IsFull()) {
-    page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
-    assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.RUnlock();
     return SplitInsert(transaction, key, value);
   }
 
   // is not full
   bool flag = hash_table_bucket_page->Insert(key, value, comparator_);
-  page->WUnlatch();
   if (flag) {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));
-  } else {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
+    bucket_guard.SetDirty();
   }
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   // LOG_DEBUG("Here is after Insert!!!");
   // VerifyIntegrity();
@@ -152,33 +181,33 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   // LOG_DEBUG("Here is before SplitInsert!!!");
   table_latch_.WLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);
+  HashTableDirectoryPage *dir_page = dir_guard.As<HashTableDirectoryPage>();
   page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
   uint32_t directory_index = KeyToDirectoryIndex(key, dir_page);
   uint32_t local_high_bit = dir_page->GetLocalHighBit(directory_index);
 
-  HASH_TABLE_BUCKET_TYPE *bucket_table_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  HASH_TABLE_BUCKET_TYPE *bucket_table_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
   // new page for new bucket page
   uint32_t ld = dir_page->GetLocalDepth(directory_index);
   if (ld == dir_page->GetGlobalDepth()) {
     if ((1 << (dir_page->GetGlobalDepth() + 1)) <= DIRECTORY_ARRAY_SIZE) {
       dir_page->IncrGlobalDepth();
     } else {
-      assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-      assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
-      page->WUnlatch();
+      bucket_guard.Drop();
+      dir_guard.Drop();
       table_latch_.WUnlock();
       return false;
     }
   }
+  dir_guard.SetDirty();
+  bucket_guard.SetDirty();
   page_id_t new_page_id = INVALID_PAGE_ID;
-  Page *new_page = buffer_pool_manager_->NewPage(&new_page_id, nullptr);
-  new_page->WLatch();
-  assert(new_page != nullptr);
+  WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id, &segment_).UpgradeWrite();
+  assert(new_guard.IsValid());
   uint32_t diff = 0x1 << dir_page->GetLocalDepth(directory_index);
-  HASH_TABLE_BUCKET_TYPE *new_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(new_page->GetData());
+  HASH_TABLE_BUCKET_TYPE *new_bucket_page = new_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
   uint32_t current_size = dir_page->Size();
   // LOG_DEBUG("AAAXXXX,%d",new_page_id);
   for (uint32_t i = local_high_bit; i < current_size; i += diff) {
@@ -204,11 +233,9 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
       }
     }
   }
-  new_page->WUnlatch();
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));
-  assert(buffer_pool_manager_->UnpinPage(new_page_id, true, nullptr));
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));
+  new_guard.Drop();
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.WUnlock();
   // if is full?
   // if (bucket_table_page->IsFull()) {
@@ -230,13 +257,12 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
   // VerifyIntegrity();
   // first,find the directorypage
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = FetchDirectoryPage();
   // second,find the page id
-  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  page_id_t bucket_page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());
   // third,find the bucket_page
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+  HASH_TABLE_BUCKET_TYPE *hash_table_bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
   bool flag = hash_table_bucket_page->Remove(key, value, comparator_);
   bool is_merge = hash_table_bucket_page->IsEmpty();
 
@@ -253,13 +279,11 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
   //   table_latch_.RUnlock();
   //  Merge(transaction, key, value);
   // }
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
   if (flag) {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));
-  } else {
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
+    bucket_guard.SetDirty();
   }
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   if (is_merge) {
     Merge(transaction, key, value);
@@ -279,7 +303,8 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   // VerifyIntegrity();
   // first,find the directorypage
   table_latch_.WLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);
+  HashTableDirectoryPage *dir_page = dir_guard.As<HashTableDirectoryPage>();
   // second,find the page id
   page_id_t bucket_page_id = KeyToPageId(key, dir_page);
   uint32_t bucket_index = KeyToDirectoryIndex(key, dir_page);
@@ -292,19 +317,16 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   uint32_t split_depth = dir_page->GetLocalDepth(split_page_index);
   // LOG_DEBUG("1:%d\t2:%d\n",bucket_index,split_page_index);
   if (local_depth <= 0 || local_depth != split_depth) {
-    // assert(buffer_pool_manager_->UnpinPage(bucket_page_id, true, nullptr));
-    assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return;
   }
   // third,find the bucket_page
-  Page *page = buffer_pool_manager_->FetchPage(bucket_page_id);
-  page->WLatch();
-  HASH_TABLE_BUCKET_TYPE *bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+  HASH_TABLE_BUCKET_TYPE *bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
   if (!bucket_page->IsEmpty()) {
-    page->WUnlatch();
-    assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
-    assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return;
   }
@@ -314,6 +336,7 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   // split_page->WLatch();
   // HASH_TABLE_BUCKET_TYPE *split_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(split_page->GetData());
   // split_page->WUnlatch();
+  dir_guard.SetDirty();
   uint32_t new_ld = 0x1 << (dir_page->GetLocalDepth(bucket_index) - 1);
   uint32_t local_mask = bucket_index % new_ld;
   uint32_t current_size = dir_page->Size();
@@ -324,13 +347,16 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
   }
   // dir_page->VerifyIntegrity();
   // dir_page->PrintDirectory();
-  page->WUnlatch();
-  assert(buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr));
-  assert(buffer_pool_manager_->DeletePage(bucket_page_id, nullptr));
   while (dir_page->CanShrink()) {
     dir_page->DecrGlobalDepth();
   }
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));
+  bucket_guard.Drop();
+  // An optimistic lookup that read the old directory may still hold the bucket pinned. It fails validation once it
+  // gets the latch and unpins the bucket, so the page can be deleted shortly after.
+  while (!buffer_pool_manager_->DeletePage(bucket_page_id, nullptr)) {
+    std::this_thread::yield();
+  }
+  dir_guard.Drop();
   table_latch_.WUnlock();
   // split_page->WUnlatch();
   // assert(buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr));
@@ -397,9 +423,9 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  uint32_t global_depth = dir_guard.As<HashTableDirectoryPage>()->GetGlobalDepth();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -410,45 +436,44 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  dir_guard.As<HashTableDirectoryPage>()->VerifyIntegrity();
+  dir_guard.Drop();
   table_latch_.RUnlock();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::PrintDir() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  HashTableDirectoryPage *dir_page = dir_guard.As<HashTableDirectoryPage>();
   uint32_t dir_size = dir_page->Size();
 
   dir_page->PrintDirectory();
   printf("dir size is: %d\n", dir_size);
   for (uint32_t idx = 0; idx < dir_size; idx++) {
     auto bucket_page_id = dir_page->GetBucketPageId(idx);
-    HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id);
-    bucket_page->PrintBucket();
-    buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr);
+    BasicPageGuard bucket_guard = FetchBucketPage(bucket_page_id);
+    bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->PrintBucket();
   }
 
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  dir_guard.Drop();
   table_latch_.RUnlock();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::RemoveAllItem(Transaction *transaction, uint32_t bucket_idx) {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  auto bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(bucket_page_id);
-  auto items = bucket_page->GetAllItem();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, false, nullptr);
+  BasicPageGuard dir_guard = FetchDirectoryPage();
+  auto bucket_page_id = dir_guard.As<HashTableDirectoryPage>()->GetBucketPageId(bucket_idx);
+  BasicPageGuard bucket_guard = FetchBucketPage(bucket_page_id);
+  auto items = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetAllItem();
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   for (auto &item : items) {
     Remove(nullptr, item.first, item.second);
   }
-
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr);
 }
 
 /*****************************************************************************
@@ -11,6 +11,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/seq_scan_executor.h"
+
+#include <algorithm>
+
 #include "concurrency/transaction_manager.h"
 
 namespace bustub {
@@ -33,8 +36,12 @@ void SeqScanExecutor::Init() {
   TableInfo *table_info = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
   // table schema
   schema_ = table_info->schema_;
+  // Scan through a ring of frames. It is capped at a quarter of the pool, so tables smaller than that are cached as
+  // usual and only larger ones are kept from flushing the pool.
+  size_t ring_size = std::min<size_t>(SCAN_RING_SIZE, exec_ctx_->GetBufferPoolManager()->GetPoolSize() / 4);
+  strategy_ = std::make_unique<BufferAccessStrategy>(std::max<size_t>(ring_size, 1));
   // iterator
-  table_iter_ = table_info->table_->Begin(exec_ctx_->GetTransaction());
+  table_iter_ = table_info->table_->Begin(exec_ctx_->GetTransaction(), strategy_.get());
   end_ = table_info->table_->End();
 }
 
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// access_trace.h
+//
+// Identification: src/include/buffer/access_trace.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The kinds of page accesses an AccessTrace records. */
+enum class AccessType : uint8_t { HIT, MISS, NEW, UNPIN, DELETE, EVICT };
+
+/**
+ * AccessTrace records the most recent page accesses of one or more buffer pools in a fixed-size ring buffer. Recording
+ * is lock-free and allocation-free: a thread claims a slot with a single atomic increment and overwrites the oldest
+ * entry, so a trace can be left attached to a busy buffer pool. Attach it with BufferPoolManager::SetAccessTrace().
+ *
+ * Entries that are being overwritten while the trace is read may come out mixed up. Read the trace once it is
+ * detached, or accept the odd garbled entry.
+ */
+class AccessTrace {
+ public:
+  /** One recorded access. */
+  struct Entry {
+    /** Nanoseconds since the trace was created. */
+    uint64_t time_ns_;
+    page_id_t page_id_;
+    AccessType type_;
+  };
+
+  /**
+   * Create a new AccessTrace.
+   * @param capacity the number of most recent accesses the trace keeps
+   */
+  explicit AccessTrace(size_t capacity);
+
+  /**
+   * Record an access.
+   * @param page_id the page that was accessed
+   * @param type the kind of access
+   */
+  void Record(page_id_t page_id, AccessType type);
+
+  /** @return the recorded accesses that are still in the ring buffer, oldest first */
+  std::vector<Entry> GetEntries() const;
+
+  /** @return the number of accesses recorded so far, including the ones that have been overwritten */
+  uint64_t GetNumRecorded() const { return next_slot_.load(); }
+
+  /**
+   * Write the recorded accesses to a text file, oldest first, one "<time_ns> <type> <page_id>" line each.
+   * @param file_name the file to write
+   * @return false if the file could not be written
+   */
+  bool Dump(const std::string &file_name) const;
+
+  /** @return the name of an access type, as written by Dump() */
+  static const char *TypeName(AccessType type);
+
+ private:
+  /** A ring buffer slot. Its fields are atomic so that concurrent writers and readers never race on them. */
+  struct Slot {
+    std::atomic<uint64_t> time_ns_{0};
+    std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+    std::atomic<AccessType> type_{AccessType::HIT};
+  };
+
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  /** The slot the next access goes into, modulo capacity_. */
+  std::atomic<uint64_t> next_slot_{0};
+  const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy confines the pages a large sequential scan reads into the buffer pool to a small ring.
+ *
+ * A scan passes its strategy to BufferPoolManager::FetchPage. Every page the scan brings into the pool (itself or via
+ * read-ahead) takes a slot in the ring. When the ring wraps around, the page in the overwritten slot is retired: the
+ * buffer pool reuses its frame before asking the replacer for a victim. The scan therefore cycles through about
+ * ring_size frames instead of pushing the rest of the working set out. Pages that were already resident when the scan
+ * fetched them are left alone.
+ *
+ * A strategy belongs to a single scan and is not thread-safe.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Create a new BufferAccessStrategy.
+   * @param ring_size the number of pages the scan may keep in the pool, at least 1
+   */
+  explicit BufferAccessStrategy(size_t ring_size);
+
+  /**
+   * Record that the scan brought a page into the pool.
+   * @param page_id the page that was read in
+   */
+  void RecordLoad(page_id_t page_id);
+
+  /**
+   * Take the page that fell out of the ring on the last RecordLoad, if any.
+   * @return the retired page, or INVALID_PAGE_ID
+   */
+  page_id_t TakeRetiredPage();
+
+  /** @return the number of slots in the ring */
+  size_t GetRingSize() const { return ring_.size(); }
+
+ private:
+  std::vector<page_id_t> ring_;
+  /** The slot the next loaded page goes into. */
+  size_t next_slot_{0};
+  page_id_t retired_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
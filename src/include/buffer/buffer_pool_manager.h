@@ -12,14 +12,23 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/access_trace.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/segment.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -30,6 +39,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Invoked on a background thread with a prefetched page, which is pinned until the callback returns. */
+  using prefetch_callback_fn = std::function<void(Page *page)>;
 
   BufferPoolManager() = default;
   /**
@@ -45,6 +56,21 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page on behalf of a scan that confines itself to a ring of frames.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's buffer access strategy
+   * @return the requested page, or nullptr if every frame is pinned
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+    auto *result = FetchPgWithStrategyImp(page_id, strategy);
+    page_id_t retired_page_id = strategy->TakeRetiredPage();
+    if (retired_page_id != INVALID_PAGE_ID) {
+      RetirePgImp(retired_page_id);
+    }
+    return result;
+  }
+
   /** Grading function. Do not modify! */
   bool UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,6 +110,130 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page and guard its pin, which is released when the guard goes away.
+   * @param page_id id of page to be fetched
+   * @param strategy if set, the buffer access strategy of the scan fetching the page
+   * @return a guard holding the page, invalid if every frame is pinned
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    Page *page = strategy != nullptr ? FetchPage(page_id, strategy) : FetchPage(page_id);
+    return BasicPageGuard(this, page);
+  }
+
+  /**
+   * Fetch a page, read latch it and guard the latch and the pin.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, invalid if every frame is pinned
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id) { return FetchPageBasic(page_id).UpgradeRead(); }
+
+  /**
+   * Fetch a page, write latch it and guard the latch and the pin.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, invalid if every frame is pinned
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id) { return FetchPageBasic(page_id).UpgradeWrite(); }
+
+  /**
+   * Create a new page in the current extent of a segment, allocating the segment a new extent once the current one is
+   * used up. A buffer pool that does not allocate extents creates the page like NewPage does.
+   * @param[out] page_id id of the created page
+   * @param segment the segment of the table or index the page belongs to
+   * @return nullptr if no new page could be created, otherwise pointer to the new page
+   */
+  Page *NewPageInSegment(page_id_t *page_id, Segment *segment);
+
+  /**
+   * Create a new page and guard its pin.
+   * @param[out] page_id id of the created page
+   * @param segment if set, the segment to create the page in
+   * @return a guard holding the new page, invalid if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id, Segment *segment = nullptr) {
+    return BasicPageGuard(this, segment != nullptr ? NewPageInSegment(page_id, segment) : NewPage(page_id));
+  }
+
+  /**
+   * Read-ahead hint: start reading the given pages into the buffer pool in the background and return immediately.
+   * The pages are not pinned, so they compete for frames like any other unpinned page, and hints may be dropped when
+   * no frame can be freed for them. Pages that are already resident are not read again.
+   * @param page_ids ids of the pages that are about to be fetched
+   * @param on_loaded if set, called with each page once it is in memory, e.g. to follow a chain of linked pages
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids, const prefetch_callback_fn &on_loaded = nullptr) {
+    PrefetchPgsImp(page_ids, on_loaded);
+  }
+
+  /**
+   * Look up a resident page without pinning it, for optimistic readers. The frame stays valid memory, but it may be
+   * handed to another page at any time, so the caller must bracket its reads with Page::OptimisticReadBegin() and
+   * Page::OptimisticReadValidate() and check that the page id is still the one it asked for.
+   * @param page_id id of the page to look up
+   * @return the frame holding the page, or nullptr if the page is not resident or the pool does not support it
+   */
+  Page *PeekPage(page_id_t page_id) { return PeekPgImp(page_id); }
+
+  /**
+   * Pin a page only if it is resident, without ever reading it from disk. Unlike PeekPage, the pin keeps the frame
+   * holding the page until it is unpinned, so this suits optimistic readers that follow a page id they have not
+   * validated yet: a page that was deleted in the meantime is never loaded again.
+   * @param page_id id of the page to pin
+   * @return a guard holding the page read latched, invalid if the page is not resident
+   */
+  ReadPageGuard FetchResidentPageRead(page_id_t page_id) {
+    return BasicPageGuard(this, FetchResidentPgImp(page_id)).UpgradeRead();
+  }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Growing adds free frames. Shrinking evicts the pages in the
+   * frames that are given up, writing back the dirty ones, and stops early at a frame whose page is pinned.
+   * @param pool_size the new number of frames
+   * @return true if the pool now has pool_size frames, false if it could not be resized (all the way)
+   */
+  bool ResizePool(size_t pool_size) { return ResizePoolImp(pool_size); }
+
+  /**
+   * Snapshot the pages resident in the buffer pool, in the order the replacer would evict them, so that a restarted
+   * pool can be warmed up with them. Pinned pages come last, since they are in use right now.
+   * @return the ids of the resident pages, coldest first
+   */
+  std::vector<page_id_t> GetHotSet() { return GetHotSetImp(); }
+
+  /**
+   * Start reading a hot set into the buffer pool in the background and return immediately. The hottest pages that fit
+   * are read in page id order, in batches, and only into free frames, so that the warm-up never evicts pages that
+   * ordinary traffic brought in meanwhile. Once they are loaded, the replacer order the hot set was saved in is
+   * restored for every page that has not been fetched yet.
+   * @param hot_set the ids of the pages to load, coldest first, as returned by GetHotSet()
+   */
+  void WarmUp(const std::vector<page_id_t> &hot_set) { WarmUpImp(hot_set); }
+
+  /**
+   * Save the hot set to a file. The file is replaced atomically, so this can be called periodically while the pool is
+   * in use as well as at shutdown.
+   * @param file_name the file to write
+   * @return false if the file could not be written
+   */
+  bool SaveHotSet(const std::string &file_name);
+
+  /**
+   * Warm up the buffer pool with a hot set saved by SaveHotSet().
+   * @param file_name the file to read
+   * @return false if the file does not exist or is not a hot set file
+   */
+  bool LoadHotSet(const std::string &file_name);
+
+  /** @return a snapshot of the buffer pool's counters */
+  BufferPoolStats GetStats() { return GetStatsImp(); }
+
+  /**
+   * Start recording every hit, miss, new page, unpin, deletion and eviction into a trace, or stop recording. The trace
+   * must stay alive until it is detached and no call into the buffer pool that started before is still running.
+   * @param trace the trace to record into, nullptr to stop recording
+   */
+  void SetAccessTrace(AccessTrace *trace) { SetAccessTraceImp(trace); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
@@ -137,6 +287,93 @@ class BufferPoolManager {
    */
   virtual bool DeletePgImp(page_id_t page_id) = 0;
 
+  /**
+   * Allocate an extent of contiguous pages on disk for a Segment. By default pages are only allocated one at a time.
+   * @param num_pages the number of pages in the extent
+   * @return the extent, or nullptr if extents are not supported
+   */
+  virtual std::shared_ptr<Extent> AllocateExtentImp(size_t num_pages) { return nullptr; }
+
+  /**
+   * Creates a new page in the buffer pool with a page id that is already allocated on disk, e.g. in an extent. Only
+   * buffer pools that allocate extents need to support this.
+   * @param page_id id of the page to create
+   * @return nullptr if no new page could be created, otherwise pointer to the new page
+   */
+  virtual Page *NewPgWithIdImp(page_id_t page_id) { return nullptr; }
+
+  /**
+   * Fetch a page on behalf of a BufferAccessStrategy. Implementations call strategy->RecordLoad(page_id) if the fetch
+   * is the first one since the page was read into the pool. By default the strategy is ignored.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's buffer access strategy
+   * @return the requested page
+   */
+  virtual Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPgImp(page_id);
+  }
+
+  /**
+   * Hint that a page that fell out of a BufferAccessStrategy's ring should be evicted before anything else. By default
+   * the hint is ignored.
+   * @param page_id id of the retired page
+   */
+  virtual void RetirePgImp(page_id_t page_id) {}
+
+  /**
+   * Look up a resident page without pinning it. By default nothing is resident, so optimistic readers always fall back
+   * to fetching the page.
+   * @param page_id id of the page to look up
+   * @return the frame holding the page, or nullptr
+   */
+  virtual Page *PeekPgImp(page_id_t page_id) { return nullptr; }
+
+  /**
+   * Pin a page if it is resident. By default nothing is resident, so optimistic readers always fall back to fetching
+   * the page.
+   * @param page_id id of the page to pin
+   * @return the pinned page, or nullptr
+   */
+  virtual Page *FetchResidentPgImp(page_id_t page_id) { return nullptr; }
+
+  /**
+   * Resize the buffer pool. By default the pool has a fixed size.
+   * @param pool_size the new number of frames
+   * @return true if the pool now has pool_size frames
+   */
+  virtual bool ResizePoolImp(size_t pool_size) { return false; }
+
+  /**
+   * Snapshot the counters. By default nothing is counted.
+   * @return the counters
+   */
+  virtual BufferPoolStats GetStatsImp() { return {}; }
+
+  /**
+   * Attach or detach an access trace. By default accesses are not traced.
+   * @param trace the trace to record into, may be nullptr
+   */
+  virtual void SetAccessTraceImp(AccessTrace *trace) {}
+
+  /**
+   * Snapshot the resident pages. By default nothing is resident.
+   * @return the ids of the resident pages, coldest first
+   */
+  virtual std::vector<page_id_t> GetHotSetImp() { return {}; }
+
+  /**
+   * Load a hot set in the background. Buffer pools without background I/O ignore it.
+   * @param hot_set the ids of the pages to load, coldest first
+   */
+  virtual void WarmUpImp(const std::vector<page_id_t> &hot_set) {}
+
+  /**
+   * Start reading pages in the background. Buffer pools without background I/O ignore the hint.
+   * @param page_ids ids of the pages to read
+   * @param on_loaded callback invoked with each loaded page, may be null
+   */
+  virtual void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, const prefetch_callback_fn &on_loaded) {}
+
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
@@ -12,12 +12,25 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -28,14 +41,22 @@ namespace bustub {
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
+  // The parallel buffer pool forwards strategy fetches and retire hints to the instance owning the page.
+  friend class ParallelBufferPoolManager;
+
  public:
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the number of frames the pool can grow to with ResizePool, 0 to keep it at pool_size
+   * @param compressed_cache_size bytes of memory for a compressed cache of evicted pages, 0 for no such cache
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0,
+                            size_t compressed_cache_size = 0);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +64,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy used to pick victim frames
+   * @param max_pool_size the number of frames the pool can grow to with ResizePool, 0 to keep it at pool_size
+   * @param compressed_cache_size bytes of memory for a compressed cache of evicted pages, 0 for no such cache
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0,
+                            size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,6 +81,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
+  /** @return the number of frames the buffer pool can grow to */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  /** @return the compressed cache of evicted pages, or nullptr if the pool has none */
+  CompressedPageCache *GetCompressedCache() { return compressed_cache_.get(); }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
@@ -63,11 +95,46 @@ class BufferPoolManagerInstance : public BufferPoolManager {
 
   void PrintExistPageId();
 
+  /**
+   * Start a background thread that writes dirty, unpinned pages to disk so that evictions find clean victims. While it
+   * runs, the replacer is asked to prefer clean frames, and a foreground miss only writes a page back when every
+   * evictable frame is dirty. The writer wakes up every interval, or as soon as the dirty ratio exceeds the high
+   * watermark, and writes pages until the dirty ratio is at or below the low watermark.
+   * @param low_watermark fraction of the pool that may stay dirty after a round of writing
+   * @param high_watermark fraction of the pool that is dirty before the writer is woken up ahead of its interval
+   * @param interval how often the writer wakes up on its own
+   */
+  void StartBackgroundWriter(double low_watermark = BGWRITER_LOW_WATERMARK,
+                             double high_watermark = BGWRITER_HIGH_WATERMARK,
+                             std::chrono::milliseconds interval = BGWRITER_INTERVAL);
+
+  /** Stop the background writer, if it is running, and wait for it to exit. */
+  void StopBackgroundWriter();
+
+  /** @return the number of resident pages that are dirty */
+  size_t GetDirtyPageNum() const { return num_dirty_; }
+
+  /**
+   * @return the number of free frames, read without taking the latch. It may be stale by the time the caller acts on
+   * it, and is only meant as a hint, e.g. for choosing an instance to allocate a page on.
+   */
+  size_t GetFreeFrameNum() const { return num_free_frames_.load(std::memory_order_relaxed); }
+
+  /** @return the number of threads currently waiting for the buffer pool latch; also just a hint */
+  size_t GetLatchWaiterNum() const { return latch_waiters_.load(std::memory_order_relaxed); }
+
+  /**
+   * Drop all queued prefetch requests and stop the prefetch threads. Later prefetch hints are ignored. The destructor
+   * calls this; a ParallelBufferPoolManager calls it on all instances before destroying any, since a prefetch callback
+   * may route new hints to another instance.
+   */
+  void StopPrefetching();
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
-   * @return the requested page
+   * @return the requested page, or nullptr if every frame is pinned or the page is not allocated
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
@@ -101,23 +168,153 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   bool DeletePgImp(page_id_t page_id) override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Allocate an extent of contiguous pages through the disk manager.
+   * @param num_pages the number of pages in the extent
+   * @return the extent
+   */
+  std::shared_ptr<Extent> AllocateExtentImp(size_t num_pages) override;
+
+  /**
+   * Creates a new page in the buffer pool with a page id that is already allocated on disk.
+   * @param page_id id of the page to create, which must map to this BPI
+   * @return nullptr if all the pages in the buffer pool are pinned, otherwise pointer to the new page
+   */
+  Page *NewPgWithIdImp(page_id_t page_id) override;
+
+  /**
+   * Flushes all the dirty pages in the buffer pool to disk. The dirty pages are snapshotted and written in page id
+   * order, runs of adjacent pages with a single write each, and the file is synced once at the end.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Queue pages to be read in by the prefetch threads, which are started on first use.
+   * @param page_ids ids of the pages to read
+   * @param on_loaded callback invoked with each loaded page, may be null
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, const prefetch_callback_fn &on_loaded) override;
+
+  /**
+   * Fetch the requested page and record it in the strategy's ring if this fetch is its first since it was read in.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's buffer access strategy
+   * @return the requested page
+   */
+  Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Queue the frame of a page retired by a BufferAccessStrategy for reuse ahead of the replacer's victims.
+   * @param page_id id of the retired page
+   */
+  void RetirePgImp(page_id_t page_id) override;
+
+  /**
+   * Look up a resident page in the page table without pinning it or touching the replacer.
+   * @param page_id id of the page to look up
+   * @return the frame holding the page, or nullptr if it is not resident
+   */
+  Page *PeekPgImp(page_id_t page_id) override;
+
+  /**
+   * Pin a page if it is in the page table, counting it as a hit. A miss neither reads the page nor takes the latch.
+   * @param page_id id of the page to pin
+   * @return the pinned page, or nullptr if it is not resident
+   */
+  Page *FetchResidentPgImp(page_id_t page_id) override;
+
+  /**
+   * Snapshot the resident pages: the evictable ones in the replacer's eviction order, then the pinned ones.
+   * @return the ids of the resident pages, coldest first
+   */
+  std::vector<page_id_t> GetHotSetImp() override;
+
+  /**
+   * Hand the hottest pages of a hot set that fit in the pool to a warm-up thread, which runs alongside the prefetch
+   * threads and is stopped with them.
+   * @param hot_set the ids of the pages to load, coldest first
+   */
+  void WarmUpImp(const std::vector<page_id_t> &hot_set) override;
+
+  /**
+   * Snapshot the counters, including those of the compressed cache if the pool has one.
+   * @return the counters
+   */
+  BufferPoolStats GetStatsImp() override;
+
+  /**
+   * Attach or detach an access trace.
+   * @param trace the trace to record into, may be nullptr
+   */
+  void SetAccessTraceImp(AccessTrace *trace) override { trace_ = trace; }
+
+  /**
+   * Resize the pool between 1 and max_pool_size frames. Frames are given up from the end of the frame array, so the
+   * frames in use always stay a prefix of it.
+   * @param pool_size the new number of frames
+   * @return true if the pool now has pool_size frames
+   */
+  bool ResizePoolImp(size_t pool_size) override;
+
+  /**
+   * Take a frame out of use for shrinking: remove it from the free list, or evict its page and write it back if it is
+   * dirty. Must be called with latch_ held, which is released while waiting for the disk.
+   * @param frame_id the frame to give up
+   * @param latch the held latch_
+   * @return false if the frame holds a pinned page
+   */
+  bool WithdrawFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *latch);
+
+  /**
+   * Fetch a page and pin it.
+   * @param page_id id of page to be fetched
+   * @param record_access false for prefetches, which must not count as a use of the page in the replacer's history
+   * @param[out] first_fetch if not null, set to whether this is the page's first fetch since it was read in
+   * @return the requested page, or nullptr if every frame is pinned or the page is not allocated
+   */
+  Page *FetchFrame(page_id_t page_id, bool record_access, bool *first_fetch = nullptr);
+
+  /** Body of the prefetch threads. */
+  void RunPrefetcher();
+
+  /**
+   * Read one page for a prefetch request and hand it to the callback, if any.
+   * @param page_id the page to read
+   * @param on_loaded callback invoked with the loaded page, may be null
+   */
+  void PrefetchPage(page_id_t page_id, const prefetch_callback_fn &on_loaded);
+
+  /**
+   * Body of the warm-up thread: read the pages in page id order, a batch at a time, into free frames, then restore
+   * their replacer order.
+   * @param hot_set the ids of the pages to load, coldest first
+   */
+  void RunWarmUp(std::vector<page_id_t> hot_set);
+
+  /**
+   * Read one batch of pages for the warm-up. Free frames are claimed for the whole batch under a single acquisition of
+   * latch_, then the pages are read with one batched submission.
+   * @param page_ids ids of the pages to read, sorted
+   * @return false if the free list ran out, so the warm-up should stop
+   */
+  bool WarmUpBatch(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Publish a page that WarmUpBatch read in and unpin it.
+   * @param p the frame the page was read into
+   */
+  void FinishWarmUpRead(Page *p);
+
+  /**
+   * Allocate a page on disk, reusing the id of a deallocated page if one maps to this BPI.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that its id can be allocated again.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -126,28 +323,250 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /**
+   * Pin a resident frame. Must be called with the frame's page table shard latched.
+   * @param frame_id the frame to pin
+   * @param record_access true to record the access in the replacer
+   * @return true if the access was recorded and is the first fetch of the page since it was read in
+   */
+  bool PinFrame(frame_id_t frame_id, bool record_access = true);
+
+  /**
+   * Find a frame to hold a new page: from the free list first, then from the frames of pages retired by a
+   * BufferAccessStrategy, and from the replacer otherwise. A victim's page table entry
+   * is removed, but its dirty contents are left in the frame for LoadFrame to write back. Must be called with latch_
+   * held.
+   * @param[out] frame_id the frame that can be reused
+   * @return false if every frame is pinned, true otherwise
+   */
+  bool GetVictimFrame(frame_id_t *frame_id);
+
+  /**
+   * Map a page to a frame and pin it, with the frame marked as doing I/O until FinishIo, so that requesters of the page
+   * pin the frame and wait for it. Must be called with latch_ held.
+   * @param frame_id the frame the page is being loaded into
+   * @param page_id id of the page
+   * @param record_access true to record the access in the replacer
+   */
+  void PublishFrame(frame_id_t frame_id, page_id_t page_id, bool record_access);
+
+  /**
+   * Lock latch_, adding the time spent waiting for it to the latch wait counter. An uncontended acquisition is not
+   * timed.
+   * @return the held latch_
+   */
+  std::unique_lock<std::mutex> AcquireLatch();
+
+  /**
+   * Record an access in the attached trace, if there is one.
+   * @param page_id the page that was accessed
+   * @param type the kind of access
+   */
+  void Trace(page_id_t page_id, AccessType type) {
+    AccessTrace *trace = trace_.load(std::memory_order_relaxed);
+    if (trace != nullptr) {
+      trace->Record(page_id, type);
+    }
+  }
+
+  /**
+   * Count a hit, and trace it.
+   * @param page_id the page that was hit
+   */
+  void CountHit(page_id_t page_id) {
+    hit_counters_[page_id % hit_counters_.size()].hits_++;
+    Trace(page_id, AccessType::HIT);
+  }
+
+  /**
+   * Fill a frame with a page's contents, from the compressed cache if it holds the page and from disk otherwise.
+   * @param page_id id of the page
+   * @param[out] page_data the frame's data
+   */
+  void ReadPageData(page_id_t page_id, char *page_data);
+
+  /**
+   * Install a page into a frame obtained from GetVictimFrame and pin it. The page table entry is published with the
+   * frame marked as doing I/O, then latch_ is released while the victim is written back and the page is read in, so
+   * only requesters of these two pages wait for the disk.
+   * @param frame_id the frame to load the page into
+   * @param page_id id of the page to install
+   * @param read_page true to read the page from disk, false to zero it (for new pages)
+   * @param record_access true to record the access in the replacer
+   * @param latch the held latch_, which is released on return
+   * @return pointer to the pinned page
+   */
+  Page *LoadFrame(frame_id_t frame_id, page_id_t page_id, bool read_page, bool record_access,
+                  std::unique_lock<std::mutex> *latch);
+
+  /**
+   * Wait until no I/O is in progress on a frame. The caller must hold a pin on the frame.
+   * @param page the frame to wait for
+   */
+  void WaitForIo(Page *page);
+
+  /**
+   * Mark a frame as done with its I/O and wake up everyone waiting for it.
+   * @param page the frame whose I/O completed
+   */
+  void FinishIo(Page *page);
+
+  /**
+   * Mark a resident page dirty, waking up the background writer if that pushes the pool over the high watermark.
+   * @param page the page that was modified
+   */
+  void MarkDirty(Page *page);
+
+  /**
+   * Mark a page clean. Callers do this before writing the page out, so a modification that races with the write
+   * leaves the page dirty.
+   * @param page the page about to be written
+   */
+  void MarkClean(Page *page);
+
+  /**
+   * Write all the dirty pages in the buffer pool to disk without syncing the file, for FlushAllPgsImp and for the
+   * ParallelBufferPoolManager, which syncs once after all of its instances have written.
+   */
+  void WriteAllDirtyPages();
+
+  /** Body of the background writer thread. */
+  void RunBackgroundWriter();
+
+  /**
+   * Write dirty, unpinned pages until at most target pages are dirty or no candidates are left.
+   * @param target number of dirty pages to stop at
+   */
+  void CleanDirtyPages(size_t target);
+
+  /**
+   * Write back one page for the background writer, if it is still resident in frame_id, unpinned and dirty.
+   * @param page_id the page to write
+   * @param frame_id the frame the page was found in
+   */
+  void WriteBackUnpinned(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Claim a resident, dirty page for writing it out, so that its frame is not evicted or deleted during the write.
+   * @param page_id the page to write
+   * @param frame_id the frame the page was found in
+   * @param[out] writing set to true if the page could not be claimed because it is already being written out
+   * @return true if the page was claimed
+   */
+  bool ClaimWriteback(page_id_t page_id, frame_id_t frame_id, bool *writing);
+
+  /**
+   * Release a claim taken by ClaimWriteback and wake up everyone waiting for it.
+   * @param page the frame that was written
+   */
+  void FinishWriteback(Page *page);
+
+  /**
+   * Wait until the background writer is done with a frame.
+   * @param page the frame to wait for
+   */
+  void WaitForWriteback(Page *page);
+
+  /** Wake up the background writer ahead of its interval. */
+  void KickBackgroundWriter();
+
+  /** Number of frames the buffer pool can grow to. */
+  const size_t max_pool_size_;
+  /** Number of frames in use. Only changes with latch_ held. */
+  std::atomic<size_t> pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /**
+   * Array of frame descriptors, with room for max_pool_size_ frames. Storage is reserved up front but descriptors are
+   * only constructed when the pool first grows over them. A frame that is given up by a shrink keeps its Page, since
+   * optimistic readers and threads waiting for its I/O may still look at it.
+   */
   Page *pages_;
+  /**
+   * The page data of all frames, PAGE_SIZE bytes per frame, in page-aligned memory that is mapped up front but only
+   * backed by physical memory once a frame is used. A shrink hands the memory of the frames it gives up back to the OS.
+   * Being page-aligned, frames can be read and written by a DiskManager in direct I/O mode without a bounce buffer.
+   */
+  char *data_arena_;
+  /** Number of frames whose Page has been constructed. Only changes with latch_ held. */
+  size_t constructed_frames_{0};
+  /** Compressed copies of evicted pages, consulted before reading from disk. Null if the pool has none. */
+  std::unique_ptr<CompressedPageCache> compressed_cache_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
   /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Frames of pages retired by a BufferAccessStrategy, with the retired page, reused before the replacer's victims. */
+  std::deque<std::pair<frame_id_t, page_id_t>> retired_frames_;
+  /** Evicted dirty pages whose contents are still being written back, mapped to the frame doing the write. */
+  std::unordered_map<page_id_t, frame_id_t> writeback_pages_;
+  /**
+   * This latch serializes frame allocation: the free list, retired_frames_, victim selection, writeback_pages_ and
+   * every insertion into or removal from the page table. Hits and unpins of resident pages never take it; they only
+   * latch their page table shard. It is never held across disk I/O.
+   */
   std::mutex latch_;
+  /** Serializes resizes, which release latch_ while they write back the pages of the frames they give up. */
+  std::mutex resize_latch_;
+
+  /** Number of resident pages that are dirty. */
+  std::atomic<size_t> num_dirty_{0};
+  /** Size of free_list_, mirrored so that it can be read without latch_. */
+  std::atomic<size_t> num_free_frames_{0};
+  /** Number of threads blocked in AcquireLatch. */
+  std::atomic<size_t> latch_waiters_{0};
+  /** True while the background writer thread runs. */
+  std::atomic<bool> writer_running_{false};
+  /** Set when a foreground thread wants the writer to run before its interval is up. */
+  std::atomic<bool> writer_kicked_{false};
+  /** Watermarks the writer was started with, as fractions of the pool. */
+  double writer_low_watermark_{0};
+  double writer_high_watermark_{0};
+  /** The writer cleans down to this many dirty pages. Recomputed when the pool is resized. */
+  std::atomic<size_t> writer_low_pages_{0};
+  /** The writer is kicked once more than this many pages are dirty. Recomputed when the pool is resized. */
+  std::atomic<size_t> writer_high_pages_{0};
+  std::chrono::milliseconds writer_interval_{BGWRITER_INTERVAL};
+  std::thread writer_;
+  /** Protects the writer's sleep; writer_cv_ is signalled to kick or stop it. */
+  std::mutex writer_latch_;
+  std::condition_variable writer_cv_;
+
+  /** A hit counter on its own cache line. */
+  struct alignas(64) HitCounter {
+    std::atomic<uint64_t> hits_{0};
+  };
+  /**
+   * Hits are counted on a stripe chosen by page id, so that hits on different pages do not contend on one counter,
+   * while hits on the same page already contend on its pin count. The other counters are only bumped on misses, which
+   * take latch_ or do I/O anyway.
+   */
+  std::array<HitCounter, PAGE_TABLE_SHARDS> hit_counters_;
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> evictions_{0};
+  std::atomic<uint64_t> writebacks_{0};
+  std::atomic<uint64_t> flushes_{0};
+  std::atomic<uint64_t> pin_failures_{0};
+  std::atomic<uint64_t> latch_wait_ns_{0};
+  /** The attached access trace, or nullptr. */
+  std::atomic<AccessTrace *> trace_{nullptr};
+
+  /** Pages waiting to be prefetched, with the callback to invoke once each is loaded. */
+  std::deque<std::pair<page_id_t, prefetch_callback_fn>> prefetch_queue_;
+  std::vector<std::thread> prefetchers_;
+  /** Set by StopPrefetching, after which no more requests are accepted. */
+  bool prefetch_stopped_{false};
+  /** Protects prefetch_queue_, prefetchers_ and prefetch_stopped_. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
 };
 }  // namespace bustub
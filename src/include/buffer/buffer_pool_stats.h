@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * A snapshot of a buffer pool's counters, as returned by BufferPoolManager::GetStats(). All counters start at zero
+ * when the buffer pool is created and only ever grow, so the difference of two snapshots covers the time in between.
+ */
+struct BufferPoolStats {
+  /** Fetches that found their page resident. */
+  uint64_t hits_{0};
+  /** Fetches that had to read their page in. */
+  uint64_t misses_{0};
+  /** Pages that were evicted to make room for another page. */
+  uint64_t evictions_{0};
+  /** Dirty pages that were written back because they were evicted. */
+  uint64_t writebacks_{0};
+  /** Dirty pages written out by FlushPage, FlushAllPages or the background writer. */
+  uint64_t flushes_{0};
+  /** Fetches and new pages that failed because every frame was pinned. */
+  uint64_t pin_failures_{0};
+  /** Total time threads spent waiting for the buffer pool latch, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+  /** Misses served by the compressed cache of evicted pages. */
+  uint64_t compressed_hits_{0};
+  /** Misses the compressed cache of evicted pages could not serve. */
+  uint64_t compressed_misses_{0};
+
+  /** Add up the counters of several buffer pools. */
+  BufferPoolStats &operator+=(const BufferPoolStats &other) {
+    hits_ += other.hits_;
+    misses_ += other.misses_;
+    evictions_ += other.evictions_;
+    writebacks_ += other.writebacks_;
+    flushes_ += other.flushes_;
+    pin_failures_ += other.pin_failures_;
+    latch_wait_ns_ += other.latch_wait_ns_;
+    compressed_hits_ += other.compressed_hits_;
+    compressed_misses_ += other.compressed_misses_;
+    return *this;
+  }
+};
+
+}  // namespace bustub
@@ -12,7 +12,10 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -23,6 +26,11 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame carries an atomic reference bit and an atomic evictable bit, so Pin and Unpin are single atomic
+ * operations that never block. Only Victim takes a mutex, to serialize movement of the clock hand; it claims a frame
+ * by clearing its evictable bit with a compare-and-swap, so a racing Pin either wins and keeps the frame or loses and
+ * finds it already removed.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -39,14 +47,41 @@ class ClockReplacer : public Replacer {
 
   bool Victim(frame_id_t *frame_id) override;
 
+  /**
+   * Sweeps like Victim, but a frame whose reference bit is clear is only taken if preferred(frame_id) holds. If no
+   * such frame turns up within two sweeps, the first unreferenced frame that was passed over is taken instead.
+   */
+  bool PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) override;
+
   void Pin(frame_id_t frame_id) override;
 
   void Unpin(frame_id_t frame_id) override;
 
+  /**
+   * Lists the evictable frames in the order the hand would reach them, those whose reference bit is clear first. This
+   * only approximates the order of later victims, since the sweep keeps clearing reference bits as it goes.
+   */
+  std::vector<frame_id_t> EvictionOrder() override;
+
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  /** Each frame's bits sit on their own cache line so that pinning one frame does not invalidate its neighbours. */
+  struct alignas(64) FrameState {
+    std::atomic<bool> referenced_{false};
+    std::atomic<bool> evictable_{false};
+  };
+
+  /** Try to take a frame out of the replacer. Only one of several racing claims (or a Pin) can succeed. */
+  bool Claim(frame_id_t frame_id);
+
+  const size_t num_pages_;
+  std::unique_ptr<FrameState[]> frames_;
+  /** Signed, because a Victim can claim a frame between an Unpin's store and its increment. */
+  std::atomic<int64_t> size_{0};
+  /** The clock hand, only moved by Victim while holding hand_latch_. */
+  size_t hand_{0};
+  std::mutex hand_latch_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a victim cache that sits between a buffer pool and the disk. The buffer pool hands it every
+ * page it evicts, once the page's contents match the disk, and asks it for every page it is about to read from disk.
+ *
+ * Pages are kept compressed, with a byte-oriented LZ77 scheme that turns the zeroed free space and the repeated tuple
+ * layouts of table pages into a handful of back references. A page that does not compress is kept as is. The cache
+ * holds at most capacity bytes of page data and drops its least recently inserted pages to make room.
+ *
+ * The cache is exclusive: a hit hands the page back to the buffer pool and removes it from the cache, so a page is
+ * never in both, and the cache never holds a copy that is older than the disk.
+ */
+class CompressedPageCache {
+ public:
+  /**
+   * Create a new CompressedPageCache.
+   * @param capacity the number of bytes of (compressed) page data the cache may hold
+   */
+  explicit CompressedPageCache(size_t capacity);
+
+  /**
+   * Add an evicted page, replacing any copy of it the cache already holds.
+   * @param page_id id of the page
+   * @param page_data the page's contents, which must match the page on disk
+   */
+  void Insert(page_id_t page_id, const char *page_data);
+
+  /**
+   * Take a page out of the cache.
+   * @param page_id id of the page
+   * @param[out] page_data the page's contents, if the page was cached
+   * @return true on a hit, false if the page has to be read from disk
+   */
+  bool Take(page_id_t page_id, char *page_data);
+
+  /**
+   * Drop a page from the cache, e.g. because it was deleted.
+   * @param page_id id of the page
+   */
+  void Erase(page_id_t page_id);
+
+  /** @return the number of lookups that found their page */
+  size_t GetHits();
+
+  /** @return the number of lookups that missed */
+  size_t GetMisses();
+
+  /** @return the number of pages in the cache */
+  size_t GetSize();
+
+  /** @return the number of bytes of page data the cache holds */
+  size_t GetUsedBytes();
+
+  /**
+   * Compress a page.
+   * @param page_data the page's contents, PAGE_SIZE bytes
+   * @param[out] compressed the compressed page
+   * @return false if the page did not compress to less than PAGE_SIZE bytes
+   */
+  static bool Compress(const char *page_data, std::vector<char> *compressed);
+
+  /**
+   * Decompress a page compressed by Compress().
+   * @param compressed the compressed page
+   * @param[out] page_data the page's contents, PAGE_SIZE bytes
+   */
+  static void Decompress(const std::vector<char> &compressed, char *page_data);
+
+ private:
+  struct Entry {
+    std::list<page_id_t>::iterator position_;
+    /** The compressed page, or the page itself if it did not compress. */
+    std::vector<char> data_;
+    bool compressed_;
+  };
+
+  /** Remove an entry. Must be called with latch_ held. */
+  void EraseEntry(std::unordered_map<page_id_t, Entry>::iterator entry);
+
+  const size_t capacity_;
+  size_t used_bytes_{0};
+  size_t hits_{0};
+  size_t misses_{0};
+  /** Cached pages, most recently inserted first. */
+  std::list<page_id_t> lru_list_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame whose K-th most recent access lies furthest in the past (its backward K-distance
+ * is the largest). Frames with fewer than K recorded accesses have an infinite backward K-distance and are evicted
+ * first, least recently first-accessed first. A single scan therefore only ever competes with other once-touched
+ * pages and cannot push out pages that have been referenced K times.
+ *
+ * Accesses that arrive within the correlated reference period of a frame's previous access (e.g. the repeated fetches
+ * of one page while a single query works on it) are collapsed into that access instead of counting as new history,
+ * and frames inside their correlated reference period are only evicted when nothing else is evictable.
+ * Time is logical: it advances by one on every recorded access.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses tracked per frame
+   * @param correlated_period accesses closer than this many ticks to the previous access are treated as correlated
+   */
+  LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_period = 0);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  bool PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  std::vector<frame_id_t> EvictionOrder() override;
+
+  size_t Size() override;
+
+ private:
+  /** Ordering key of an evictable frame: frames with fewer than K accesses first, then by the relevant timestamp. */
+  using EvictionKey = std::tuple<bool, uint64_t, frame_id_t>;
+
+  struct FrameHistory {
+    /** The K most recent uncorrelated access timestamps, oldest first. */
+    std::vector<uint64_t> history_;
+    /** Timestamp of the most recent access, correlated or not. */
+    uint64_t last_access_{0};
+    /** True if history_ only holds the time the frame was unpinned, because it was never accessed. */
+    bool unreferenced_{false};
+    bool evictable_{false};
+  };
+
+  void Access(FrameHistory *frame);
+  /** @return true if the frame's most recent access is outside its correlated reference period */
+  bool Uncorrelated(frame_id_t frame_id) const;
+  void Evict(std::set<EvictionKey>::iterator victim, frame_id_t *frame_id);
+  EvictionKey KeyOf(frame_id_t frame_id) const;
+
+  const size_t k_;
+  const uint64_t correlated_period_;
+  uint64_t current_timestamp_{0};
+  std::vector<FrameHistory> frames_;
+  /** Evictable frames, ordered by eviction priority. */
+  std::set<EvictionKey> evictable_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
 #include <mutex>  // NOLINT
 #include <vector>
@@ -41,6 +42,9 @@ class LRUReplacer : public Replacer {
   // If the Replacer is empty return False.
   bool Victim(frame_id_t *frame_id) override;
 
+  // Like Victim, but returns the least recently used frame for which preferred holds if there is one.
+  bool PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) override;
+
   // This method should be called after a page is pinned to a frame in the BufferPoolManager.
   // It should remove the frame containing the pinned page from the LRUReplacer.
   void Pin(frame_id_t frame_id) override;
@@ -49,6 +53,9 @@ class LRUReplacer : public Replacer {
   // This method should add the frame containing the unpinned page to the LRUReplacer.
   void Unpin(frame_id_t frame_id) override;
 
+  // Lists the unpinned frames from least to most recently used.
+  std::vector<frame_id_t> EvictionOrder() override;
+
   // This method returns the number of frames that are currently in the LRUReplacer.
   size_t Size() override;
 
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the page ids that are resident in a buffer pool to the frames holding them.
+ *
+ * The table is split into independently latched shards, so lookups of different pages do not contend on a single
+ * mutex. Callers that must act on a frame atomically with respect to its mapping (e.g. pin it on a hit, or check that
+ * it is still unpinned before evicting it) pass a callback that runs while the owning shard is latched.
+ */
+class PageTable {
+ public:
+  /**
+   * Creates a new PageTable.
+   * @param num_shards the number of shards, must be a power of two
+   */
+  explicit PageTable(size_t num_shards);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Looks up a page and, if it is resident, invokes fn(frame_id) with its shard latched in shared mode.
+   * @param page_id the page to look up
+   * @param fn callback invoked with the frame holding the page
+   * @return true if the page was found, false otherwise
+   */
+  template <typename Fn>
+  bool Find(page_id_t page_id, Fn &&fn) {
+    Shard &shard = GetShard(page_id);
+    std::shared_lock latch(shard.latch_);
+    auto it = shard.map_.find(page_id);
+    if (it == shard.map_.end()) {
+      return false;
+    }
+    fn(it->second);
+    return true;
+  }
+
+  /**
+   * Looks up a page.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page was found, false otherwise
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id);
+
+  /**
+   * Maps a page to a frame. An existing mapping of the page is left as it is.
+   * @param page_id the page id
+   * @param frame_id the frame holding the page
+   * @return true if the mapping was added, false if the page was already in the table
+   */
+  bool Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes a page if pred(frame_id) holds, evaluated with the shard latched in exclusive mode.
+   * @param page_id the page to remove
+   * @param pred predicate deciding whether the mapping may be removed
+   * @return true if the page was found and removed, false otherwise
+   */
+  template <typename Pred>
+  bool RemoveIf(page_id_t page_id, Pred &&pred) {
+    Shard &shard = GetShard(page_id);
+    std::unique_lock latch(shard.latch_);
+    auto it = shard.map_.find(page_id);
+    if (it == shard.map_.end() || !pred(it->second)) {
+      return false;
+    }
+    shard.map_.erase(it);
+    size_--;
+    return true;
+  }
+
+  /**
+   * Invokes fn(page_id, frame_id) for every mapping, latching one shard at a time in shared mode.
+   * @param fn callback invoked for each resident page
+   */
+  template <typename Fn>
+  void ForEach(Fn &&fn) {
+    for (size_t i = 0; i < num_shards_; i++) {
+      std::shared_lock latch(shards_[i].latch_);
+      for (const auto &entry : shards_[i].map_) {
+        fn(entry.first, entry.second);
+      }
+    }
+  }
+
+  /** @return the number of resident pages */
+  size_t Size() const { return size_.load(); }
+
+ private:
+  /** Each shard sits on its own cache line so that latching one shard does not invalidate its neighbours. */
+  struct alignas(64) Shard {
+    std::shared_mutex latch_;
+    std::unordered_map<page_id_t, frame_id_t> map_;
+  };
+
+  /**
+   * Page ids handed out by a parallel buffer pool are striped modulo the number of instances, so the shard is picked
+   * with a multiplicative hash rather than a plain modulo to keep every shard in use.
+   */
+  Shard &GetShard(page_id_t page_id) {
+    return shards_[static_cast<uint64_t>(static_cast<uint32_t>(page_id) * 0x9E3779B1U) >> shard_shift_];
+  }
+
+  const size_t num_shards_;
+  const uint32_t shard_shift_;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace bustub
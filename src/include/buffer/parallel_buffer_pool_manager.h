@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/buffer_pool_manager_instance.h"
 #include "recovery/log_manager.h"
@@ -29,9 +32,13 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every BufferPoolManagerInstance
+   * @param max_pool_size the number of frames each BufferPoolManagerInstance can grow to, 0 to keep it at pool_size
+   * @param compressed_cache_size bytes of compressed cache of evicted pages per BufferPoolManagerInstance, 0 for none
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -41,6 +48,17 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * Start a background writer in every BufferPoolManagerInstance.
+   * @see BufferPoolManagerInstance::StartBackgroundWriter
+   */
+  void StartBackgroundWriter(double low_watermark = BGWRITER_LOW_WATERMARK,
+                             double high_watermark = BGWRITER_HIGH_WATERMARK,
+                             std::chrono::milliseconds interval = BGWRITER_INTERVAL);
+
+  /** Stop the background writers of all BufferPoolManagerInstances. */
+  void StopBackgroundWriter();
+
  protected:
   /**
    * @param page_id id of page
@@ -55,6 +73,42 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page from the responsible BufferPoolManagerInstance on behalf of a BufferAccessStrategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's buffer access strategy
+   * @return the requested page
+   */
+  Page *FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Forward a retired page to the BufferPoolManagerInstance holding it.
+   * @param page_id id of the retired page
+   */
+  void RetirePgImp(page_id_t page_id) override;
+
+  /**
+   * Look up a resident page in the responsible BufferPoolManagerInstance without pinning it.
+   * @param page_id id of the page to look up
+   * @return the frame holding the page, or nullptr if it is not resident
+   */
+  Page *PeekPgImp(page_id_t page_id) override;
+
+  /**
+   * Pin a page in the responsible BufferPoolManagerInstance if it is resident there.
+   * @param page_id id of the page to pin
+   * @return the pinned page, or nullptr if it is not resident
+   */
+  Page *FetchResidentPgImp(page_id_t page_id) override;
+
+  /**
+   * Spread a new total pool size evenly over the BufferPoolManagerInstances. Page ids are striped over the instances,
+   * so instances are resized rather than added or removed.
+   * @param pool_size the new total number of frames
+   * @return true if every instance was resized to its share
+   */
+  bool ResizePoolImp(size_t pool_size) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -71,7 +125,10 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   bool FlushPgImp(page_id_t page_id) override;
 
   /**
-   * Creates a new page in the buffer pool.
+   * Creates a new page in the buffer pool. The instance that allocates it is picked by two choices: the next instance
+   * in round-robin order and a pseudo-randomly chosen other one, of which the one with more free frames wins, or, if
+   * they have equally many, the one with fewer threads waiting for its latch. Instances are tried in order from there
+   * until one can make room.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
@@ -85,13 +142,64 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   bool DeletePgImp(page_id_t page_id) override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Allocate an extent of contiguous pages. The instances share a disk manager, so the first instance allocates it;
+   * the extent's pages are striped over the instances like any other pages.
+   * @param num_pages the number of pages in the extent
+   * @return the extent
+   */
+  std::shared_ptr<Extent> AllocateExtentImp(size_t num_pages) override;
+
+  /**
+   * Creates a new page with an allocated page id in the BufferPoolManagerInstance the id maps to.
+   * @param page_id id of the page to create
+   * @return nullptr if all the pages of that instance are pinned, otherwise pointer to the new page
+   */
+  Page *NewPgWithIdImp(page_id_t page_id) override;
+
+  /**
+   * Flushes all the pages in the buffer pool to disk. Every instance writes its dirty pages, and the file is synced
+   * once at the end.
    */
   void FlushAllPgsImp() override;
 
-  std::vector<BufferPoolManager *> bpis_;
+  /**
+   * Forward prefetch hints to the BufferPoolManagerInstances responsible for the pages.
+   * @param page_ids ids of the pages to read
+   * @param on_loaded callback invoked with each loaded page, may be null
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, const prefetch_callback_fn &on_loaded) override;
+
+  /**
+   * Concatenate the hot sets of all BufferPoolManagerInstances. Only the order among the pages of one instance
+   * matters, since each instance is warmed up separately.
+   * @return the ids of the resident pages, coldest first within each instance
+   */
+  std::vector<page_id_t> GetHotSetImp() override;
+
+  /**
+   * Split a hot set by instance, keeping its order, and warm up every instance with its share.
+   * @param hot_set the ids of the pages to load, coldest first
+   */
+  void WarmUpImp(const std::vector<page_id_t> &hot_set) override;
+
+  /**
+   * Add up the counters of all BufferPoolManagerInstances.
+   * @return the counters
+   */
+  BufferPoolStats GetStatsImp() override;
+
+  /**
+   * Attach or detach an access trace on all BufferPoolManagerInstances, which then share it.
+   * @param trace the trace to record into, may be nullptr
+   */
+  void SetAccessTraceImp(AccessTrace *trace) override;
+
+  /** Disk manager shared by all BufferPoolManagerInstances. */
+  DiskManager *disk_manager_;
+  std::vector<BufferPoolManagerInstance *> bpis_;
   size_t num_instances_;
-  int start_index_;
-  size_t pool_size_;
+  /** Round-robin position of the next page allocation. */
+  std::atomic<size_t> next_instance_{0};
+  std::atomic<size_t> pool_size_;
 };
 }  // namespace bustub
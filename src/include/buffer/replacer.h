@@ -12,10 +12,16 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a buffer pool can be configured with. */
+enum class ReplacerType { LRU, LRUK, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -31,6 +37,18 @@ class Replacer {
    */
   virtual bool Victim(frame_id_t *frame_id) = 0;
 
+  /**
+   * Remove a victim frame, preferring frames for which preferred(frame_id) holds. Among preferred frames the one the
+   * replacement policy would evict first is chosen; if no frame is preferred this behaves like Victim. The buffer pool
+   * uses it to pass over dirty frames while a background writer is cleaning them.
+   * @param[out] frame_id id of frame that was removed
+   * @param preferred predicate marking the frames that should be evicted first
+   * @return true if a victim frame was found, false otherwise
+   */
+  virtual bool PreferredVictim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &preferred) {
+    return Victim(frame_id);
+  }
+
   /**
    * Pins a frame, indicating that it should not be victimized until it is unpinned.
    * @param frame_id the id of the frame to pin
@@ -43,6 +61,27 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Forgets a frame whose page left the buffer pool without going through Victim (it was deleted, or its frame was
+   * reused directly). Unlike Pin, any access history kept for the frame is dropped as well.
+   * @param frame_id the id of the frame to forget
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Records that the page held by a frame was accessed. This is called on every fetch, whether or not the frame was
+   * already pinned. Policies that only order frames by the time they were unpinned can ignore it.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Lists the frames that can be victimized, in the order the policy would victimize them, without removing them. The
+   * buffer pool saves this order to warm up a restarted pool. Policies that cannot tell return an empty list.
+   * @return the evictable frames, first victim first
+   */
+  virtual std::vector<frame_id_t> EvictionOrder() { return {}; }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
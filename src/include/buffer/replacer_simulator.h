@@ -0,0 +1,98 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_simulator.h
+//
+// Identification: src/include/buffer/replacer_simulator.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ReplacerSimulator replays a page reference string against a Replacer, the way a buffer pool of a given size would
+ * drive it, without doing any I/O. It is used to compare replacement policies offline.
+ *
+ * Every reference is a fetch that is unpinned right away: a hit records the access and pins and unpins the frame, a
+ * miss takes a free frame or asks the replacer for a victim and loads the page into it.
+ */
+class ReplacerSimulator {
+ public:
+  /** Creates a replacer for a pool with the given number of frames. */
+  using ReplacerFactory = std::function<std::unique_ptr<Replacer>(size_t num_frames)>;
+
+  /** The outcome of one replay. */
+  struct Result {
+    uint64_t hits_{0};
+    uint64_t misses_{0};
+    /** Wall clock time of the whole replay, page table lookups included. */
+    uint64_t elapsed_ns_{0};
+
+    /** @return the fraction of references that were hits */
+    double HitRatio() const;
+    /** @return the average time spent per reference, in nanoseconds */
+    double NsPerReference() const;
+  };
+
+  /**
+   * @param type one of the replacement policies a buffer pool can be configured with
+   * @return a factory creating that policy with the same parameters a BufferPoolManagerInstance uses
+   */
+  static ReplacerFactory FactoryFor(ReplacerType type);
+
+  /**
+   * Replay a reference string.
+   * @param factory creates the replacer under test
+   * @param pool_size the number of frames of the simulated pool
+   * @param references the page ids to fetch, in order
+   * @return the hit and miss counts and the time taken
+   */
+  static Result Replay(const ReplacerFactory &factory, size_t pool_size, const std::vector<page_id_t> &references);
+
+  /**
+   * Generate references that follow a Zipfian distribution over num_pages pages. Page 0 is the most popular one.
+   * @param num_pages the number of distinct pages
+   * @param length the number of references
+   * @param theta the skew, 0 for uniform; 0.99 is the usual YCSB setting
+   * @param seed seed of the random number generator
+   */
+  static std::vector<page_id_t> ZipfianTrace(size_t num_pages, size_t length, double theta, uint32_t seed);
+
+  /**
+   * Generate Zipfian references interleaved with sequential scans, the mix that defeats plain LRU. Each reference
+   * starts a scan with a probability that makes about scan_fraction of all references part of one. A scan reads
+   * scan_length consecutive pages from a random starting page.
+   * @param num_pages the number of distinct pages
+   * @param length the number of references
+   * @param theta the skew of the point references
+   * @param scan_fraction the share of references that belong to scans, between 0 and 1
+   * @param scan_length the number of pages one scan reads
+   * @param seed seed of the random number generator
+   */
+  static std::vector<page_id_t> ScanMixedTrace(size_t num_pages, size_t length, double theta, double scan_fraction,
+                                               size_t scan_length, uint32_t seed);
+
+  /**
+   * Read the references out of a file written by AccessTrace::Dump(). Hits, misses and new pages are references; the
+   * other recorded events are the buffer pool's reaction to them and are skipped.
+   * @param file_name the trace file
+   * @param[out] references the page ids that were fetched, in order
+   * @return false if the file could not be read or is malformed
+   */
+  static bool LoadTrace(const std::string &file_name, std::vector<page_id_t> *references);
+};
+
+}  // namespace bustub
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// segment.h
+//
+// Identification: src/include/buffer/segment.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Segment is the space a table heap or an index grows into. It owns an extent of contiguous pages on disk at a time,
+ * and hands the extent's page ids out in order when its owner creates pages with BufferPoolManager::NewPageInSegment.
+ * The owner's pages are therefore allocated extent by extent instead of being interleaved with the pages of every
+ * other table, and a scan over them reads long runs of adjacent pages.
+ *
+ * Only the pages taken from the current extent are allocated on disk. The unused rest of it is freed once the segment
+ * goes away, and is free after a restart in any case, so opening a table or index again does not leave pages behind.
+ *
+ * A segment is thread-safe; concurrent page creations take the extent's pages one after the other.
+ */
+class Segment {
+  friend class BufferPoolManager;
+
+ public:
+  /**
+   * Create a new Segment.
+   * @param extent_size the number of pages per extent, at least 1
+   */
+  explicit Segment(size_t extent_size = EXTENT_SIZE) : extent_size_(extent_size) {}
+
+  /** @return the number of pages per extent */
+  size_t GetExtentSize() const { return extent_size_; }
+
+ private:
+  const size_t extent_size_;
+  /** Held while a page is created from the extent, so that a page id is never handed out twice. */
+  std::mutex latch_;
+  /** The current extent, null before the first page is created. */
+  std::shared_ptr<Extent> extent_;
+};
+
+}  // namespace bustub
@@ -23,11 +23,18 @@ namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file
+   * @param warm_restart if true, the buffer pool is warmed up with the hot set the previous instance saved next to the
+   * database file, and saves its own hot set there on shutdown
+   * @param direct_io if true, the database file is read and written with O_DIRECT, so pages are only cached by the
+   * buffer pool and not by the OS as well
+   */
+  explicit BustubInstance(const std::string &db_file_name, bool warm_restart = false, bool direct_io = false) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, direct_io);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
@@ -40,12 +47,21 @@ class BustubInstance {
 
     // checkpoints
     checkpoint_manager_ = new CheckpointManager(transaction_manager_, log_manager_, buffer_pool_manager_);
+
+    // warm restarts
+    if (warm_restart) {
+      hot_set_file_name_ = db_file_name + ".hotset";
+      buffer_pool_manager_->LoadHotSet(hot_set_file_name_);
+    }
   }
 
   ~BustubInstance() {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    if (!hot_set_file_name_.empty()) {
+      buffer_pool_manager_->SaveHotSet(hot_set_file_name_);
+    }
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -60,6 +76,8 @@ class BustubInstance {
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
   CheckpointManager *checkpoint_manager_;
+  /** Where the buffer pool's hot set is kept across restarts, empty if warm restarts are off. */
+  std::string hot_set_file_name_;
 };
 
 }  // namespace bustub
@@ -35,6 +35,21 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;                          // hint huge pages for the data arena
+static constexpr int PAGE_TABLE_SHARDS = 16;                                  // shards per buffer pool page table
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window of the LRU-K replacer
+static constexpr int LRUK_CORRELATED_PERIOD = 0;                              // correlated reference period of LRU-K
+static constexpr double BGWRITER_LOW_WATERMARK = 0.1;                         // dirty ratio the writer cleans down to
+static constexpr double BGWRITER_HIGH_WATERMARK = 0.3;                        // dirty ratio that wakes the writer early
+static constexpr std::chrono::milliseconds BGWRITER_INTERVAL{100};            // background writer wakeup interval
+static constexpr int PREFETCH_WORKERS = 2;                                    // prefetch threads per buffer pool
+static constexpr int TABLE_HEAP_READAHEAD = 8;                                // pages read ahead by table scans
+static constexpr int SCAN_RING_SIZE = 32;                                     // frames a sequential scan cycles through
+static constexpr int OPTIMISTIC_READ_RETRIES = 3;                             // optimistic attempts before latching
+static constexpr int FLUSH_RUN_SIZE = 64;                                     // most pages per vectored flush write
+static constexpr int WARMUP_BATCH_SIZE = 64;                                  // pages per warm-up batch
+static constexpr int DISK_IO_QUEUE_DEPTH = 64;                                // io_uring submission queue entries
+static constexpr int EXTENT_SIZE = 64;                                        // contiguous pages per segment extent
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
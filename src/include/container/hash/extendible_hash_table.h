@@ -130,17 +130,29 @@ class ExtendibleHashTable {
   /**
    * Fetches the directory page from the buffer pool manager.
    *
-   * @return a pointer to the directory page
+   * @return a guard holding the pin on the directory page
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  BasicPageGuard FetchDirectoryPage();
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
    *
    * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * @return a guard holding the pin on the bucket page
    */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+  BasicPageGuard FetchBucketPage(page_id_t bucket_page_id);
+
+  /**
+   * Looks up a key without latching the table or pinning the directory page. The directory is read optimistically and
+   * validated against its version after the bucket has been latched, so a concurrent split or merge that moved the key
+   * is detected.
+   *
+   * @param key the key to look up
+   * @param[out] result the values associated with the key
+   * @param[out] found whether the key was found
+   * @return false if the directory changed or was not resident, in which case the caller must retry
+   */
+  bool OptimisticGetValue(const KeyType &key, std::vector<ValueType> *result, bool *found);
 
   /**
    * Performs insertion with an optional bucket splitting.  If the
@@ -174,9 +186,12 @@ class ExtendibleHashTable {
   // member variables
   page_id_t directory_page_id_;
   BufferPoolManager *buffer_pool_manager_;
+  /** The extents the directory and bucket pages are created in. */
+  Segment segment_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts and removes, writers are splits and merges. Splits and merges also write latch the
+  // directory page, so that lookups reading it optimistically notice them.
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
 };
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -51,6 +53,9 @@ class SeqScanExecutor : public AbstractExecutor {
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
 
+  /** Keeps the pages of the scan from pushing the rest of the working set out of the buffer pool */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
+
   /** new added member by hs **/
   Schema schema_;
   //
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_io_ring.h
+//
+// Identification: src/include/storage/disk/disk_io_ring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** An asynchronous page read or write, see DiskManager::SubmitBatch(). */
+struct DiskRequest {
+  /** True for a write, false for a read. */
+  bool is_write_;
+  /** The page buffer, read into or written from. It must stay valid until the request completes. */
+  char *data_;
+  page_id_t page_id_;
+  /** Set to true once the request completed, or to false if it failed. */
+  std::promise<bool> callback_;
+};
+
+/**
+ * DiskIoRing submits page I/O on one file through a Linux io_uring, set up with raw system calls. Submissions are
+ * batched into a single io_uring_enter call, and a completion thread reaps the results and fulfills the requests'
+ * promises, so a submitting thread can keep many reads and writes in flight without blocking.
+ *
+ * Requests the ring cannot finish, because the kernel rejected the operation or transferred less than a page (e.g. a
+ * read at the end of the file), are completed synchronously by a fallback function on the completion thread. If the
+ * ring itself fails, the requests it still holds and every later one are completed by the fallback function as well.
+ */
+class DiskIoRing {
+ public:
+  /** Completes a request synchronously and returns whether it succeeded. */
+  using fallback_fn = std::function<bool(const DiskRequest &)>;
+  /** Maps a page id to the byte offset of the page in the file. */
+  using offset_fn = int64_t (*)(page_id_t);
+
+  /**
+   * Set up a ring. If the kernel does not support io_uring, or does not allow it, the ring is unavailable.
+   * @param fd the file all requests go to
+   * @param page_offset maps page ids to file offsets
+   * @param queue_depth the number of submission queue entries
+   * @param fallback completes requests the ring could not
+   */
+  DiskIoRing(int fd, offset_fn page_offset, unsigned queue_depth, fallback_fn fallback);
+
+  /** Waits for the requests in flight and tears the ring down. */
+  ~DiskIoRing();
+
+  /** @return true if the ring was set up and requests can be submitted */
+  bool IsAvailable() const { return ring_fd_ >= 0; }
+
+  /**
+   * Submit requests, taking ownership of them. Blocks only while the ring holds as many requests as it can complete
+   * without overflowing.
+   * @param requests the requests, left empty
+   */
+  void Submit(std::vector<DiskRequest> *requests);
+
+ private:
+  /** Reaps completions until the ring is torn down. */
+  void RunReaper();
+
+  /** Push a request into the submission queue, or a no-op if request is nullptr; latch_ must be held. */
+  void Prepare(DiskRequest *request);
+
+  /**
+   * Hand count prepared entries to the kernel; latch_ must be held. If the kernel refuses them, the entries it did not
+   * take are taken back out of the submission queue, their requests are completed by the fallback function, and the
+   * ring is marked broken.
+   * @return false if the ring broke
+   */
+  bool Enter(unsigned count);
+
+  /** Unmap the ring memory and close the ring. */
+  void Close();
+
+  const int fd_;
+  const offset_fn page_offset_;
+  const fallback_fn fallback_;
+  int ring_fd_{-1};
+
+  // the shared ring memory
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned *sq_array_{nullptr};
+  unsigned sq_entries_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned cq_mask_{0};
+  void *cqes_{nullptr};
+  unsigned cq_entries_{0};
+
+  /** Protects the submission queue, in_flight_ and broken_. */
+  std::mutex latch_;
+  /** Signalled when requests complete. */
+  std::condition_variable completed_cv_;
+  /** Requests submitted and not yet reaped. */
+  std::unordered_set<DiskRequest *> in_flight_;
+  /** Set once io_uring_enter failed for good; requests are then completed synchronously. */
+  bool broken_{false};
+  /** Set when the completion thread gave up waiting for completions and exited. */
+  bool reaper_exited_{false};
+  std::thread reaper_;
+};
+
+}  // namespace bustub
@@ -15,52 +15,194 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/disk_io_ring.h"
 
 namespace bustub {
 
+/**
+ * An extent of contiguous pages handed out by DiskManager::AllocateExtent(). Its pages are taken one at a time, in
+ * order, and only the pages that were taken are recorded as allocated on disk. Once the DiskManager is the only holder
+ * of the extent left, the pages that were never taken are freed again.
+ */
+struct Extent {
+  Extent(page_id_t first_page_id, page_id_t end_page_id)
+      : first_page_id_(first_page_id), next_page_id_(first_page_id), end_page_id_(end_page_id) {}
+
+  const page_id_t first_page_id_;
+  /** The next page to take; the extent is used up once it reaches end_page_id_. */
+  std::atomic<page_id_t> next_page_id_;
+  const page_id_t end_page_id_;
+  /** next_page_id_ as of the last time the bitmaps were written; only the DiskManager uses it. */
+  page_id_t written_next_page_id_{INVALID_PAGE_ID};
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O (pread/pwrite) on a shared file descriptor, without a latch, so any
+ * number of threads can have page I/O in flight at once. Writes are handed to the operating system and are durable
+ * only after the next Sync().
+ *
+ * In direct I/O mode the database file is opened with O_DIRECT, so pages bypass the operating system's page cache and
+ * are cached once, by the buffer pool, instead of twice. Page buffers should then be aligned to PAGE_SIZE, as the
+ * buffer pool's frames are; other buffers are copied through an aligned bounce buffer.
+ *
+ * Pages can also be read and written asynchronously. Those requests go through an io_uring, set up on first use, so a
+ * single thread can keep many of them in flight; where io_uring is unavailable they are completed synchronously.
+ *
+ * The database file starts with a one-page file header recording the file format version, the page size and the
+ * widths of page ids and LSNs. Pages follow in groups of PAGES_PER_BITMAP, each group preceded by a bitmap page with
+ * one bit per page of the group, set while the page is allocated. Offsets are computed in 64 bits, so page ids address
+ * the whole 8 TB that a 31-bit page id allows. A file written with a different format is rejected when it is opened,
+ * instead of being misread.
+ *
+ * The bitmaps are kept in memory and written back by Sync(), so page allocations survive a restart. Freed page ids
+ * are handed out again before the file is extended, and the file system is told to drop the blocks of freed pages.
+ *
+ * The page and log I/O methods are virtual, so that a DiskManagerMemory can stand in for a DiskManager.
  */
 class DiskManager {
  public:
+  /** The version of the database file format; bump it whenever the layout of the file or of its pages changes. */
+  static constexpr uint32_t FORMAT_VERSION = 2;
+
+  /** The size of the file header that precedes page 0, a whole page so that pages stay aligned for O_DIRECT. */
+  static constexpr int64_t FILE_HEADER_SIZE = PAGE_SIZE;
+
+  /** The number of pages whose allocation one bitmap page tracks. */
+  static constexpr int64_t PAGES_PER_BITMAP = PAGE_SIZE * 8;
+
+  /** @return the byte offset of a page in the database file */
+  static int64_t PageOffset(page_id_t page_id) {
+    // every group of pages is preceded by its bitmap page
+    return FILE_HEADER_SIZE + (page_id + page_id / PAGES_PER_BITMAP + 1) * PAGE_SIZE;
+  }
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io true to open the database file with O_DIRECT; ignored if the file system does not support it
+   * @throws Exception if the file cannot be opened, or holds something other than a database of this format version
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
-  ~DiskManager() = default;
+  /** Closes the files if ShutDown() was not called. */
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager, syncing the database file, and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. The write is not synced; call Sync() to make it durable.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Write several pages to the database file. Pages with adjacent ids are written together, with one pwritev call
+   * per run. Like WritePage, this does not sync the file; call Sync() once the last pages are written.
+   * @param pages the ids of the pages and their raw data, in any order; of two writes to one page the later one wins
+   */
+  virtual void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /**
+   * Make all completed writes to the database file, and the page allocations so far, durable.
+   */
+  virtual void Sync();
+
+  /**
+   * Read a page from the database file. The part of the page that lies beyond the end of the file reads as zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read several pages from the database file. Pages with adjacent ids are read together, with one preadv call per
+   * run; like ReadPage, the part of a page that lies beyond the end of the file reads as zeros.
+   * @param pages the ids of the pages and their output buffers, in any order
+   */
+  virtual void ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages);
+
+  /**
+   * Start reading a page from the database file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the read completes
+   * @return a future that becomes true once the page is in page_data, or false on an I/O error
+   */
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /**
+   * Start writing a page to the database file. Like WritePage, the write is not synced.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay valid and unchanged until the write completes
+   * @return a future that becomes true once the page is written, or false on an I/O error
+   */
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Submit several reads and writes at once, with a single system call where possible. Take the futures of the
+   * requests' callbacks before submitting them.
+   * @param requests the requests, left empty
+   */
+  virtual void SubmitBatch(std::vector<DiskRequest> *requests);
+
+  /**
+   * Allocate the free page with the lowest id that is congruent to offset modulo stride. Each instance of a
+   * ParallelBufferPoolManager allocates with its own offset, so it only gets page ids that map back to it.
+   * @param stride the number of classes page ids are striped into
+   * @param offset the class of the page id, less than stride
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t offset = 0);
+
+  /**
+   * Allocate an extent: the free run of num_pages contiguous pages with the lowest ids that starts at a multiple of
+   * num_pages. Extents are aligned so that they never straddle the groups of pages that bitmap pages track, as long
+   * as num_pages divides PAGES_PER_BITMAP, and so are contiguous in the file.
+   *
+   * All pages of the extent count as allocated while the caller holds the extent, but only the pages it took are
+   * written to the bitmaps. The rest is freed by the next extent allocation or Sync() after the caller dropped the
+   * extent, and is free after a restart in any case.
+   * @param num_pages the number of pages in the extent
+   * @return the extent
+   */
+  std::shared_ptr<Extent> AllocateExtent(size_t num_pages = EXTENT_SIZE);
+
+  /**
+   * Free a page, so that a later allocation can reuse its id. Freeing a page that is not allocated has no effect.
+   * @param page_id id of the page
+   */
+  virtual void DeallocatePage(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  bool IsPageAllocated(page_id_t page_id);
+
+  /** @return true if the database file was opened with O_DIRECT */
+  bool IsDirectIo() const { return direct_io_; }
+
+  /** @return true if asynchronous requests go through io_uring, false if they are completed synchronously */
+  bool IsAsyncIoAvailable() { return GetIoRing() != nullptr; }
 
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
    * @param size size of log entry
    */
-  void WriteLog(char *log_data, int size);
+  virtual void WriteLog(char *log_data, int size);
 
   /**
    * Read a log entry from the log file.
@@ -69,7 +211,7 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  virtual bool ReadLog(char *log_data, int size, int64_t offset);
 
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
@@ -89,20 +231,86 @@ class DiskManager {
   /** Checks if the non-blocking flush future was set. */
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
+ protected:
+  /** Creates a disk manager without files, for subclasses that keep pages elsewhere. */
+  DiskManager() : num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {}
+
+  int num_flushes_;
+  std::atomic<int> num_writes_;
+  bool flush_log_;
+  std::future<void> *flush_log_f_;
+
  private:
-  int GetFileSize(const std::string &file_name);
+  int64_t GetFileSize(const std::string &file_name);
+
+  /** Write the file header into a new database file, or check the header of an existing one. */
+  void InitFileHeader();
+
+  /** Read the allocation bitmaps of an existing database file. */
+  void LoadBitmaps();
+
+  /** Write the bitmap pages that changed since they were last written; allocation_latch_ must be held. */
+  bool WriteBitmaps();
+
+  /** @return the byte offset of the bitmap page of a group of pages */
+  static int64_t BitmapOffset(int64_t group) { return FILE_HEADER_SIZE + group * (PAGES_PER_BITMAP + 1) * PAGE_SIZE; }
+
+  /** Whether a page is allocated; allocation_latch_ must be held. */
+  bool TestAllocated(page_id_t page_id) const;
+
+  /** Set or clear the bit of a page; allocation_latch_ must be held. */
+  void SetAllocated(page_id_t page_id, bool allocated);
+
+  /** Mark a free page as allocated and take it out of the allocation classes; allocation_latch_ must be held. */
+  void TakePage(page_id_t page_id);
+
+  /** Mark an allocated page as free and offer it for reuse; allocation_latch_ must be held. */
+  void FreePage(page_id_t page_id);
+
+  /** Free the pages that were never taken of the extents no one else holds any more; allocation_latch_ must be held. */
+  void ReleaseExtents();
+
+  /** The page ids an AllocatePage() stride and offset hands out. */
+  struct AllocationClass {
+    /** Free ids of the class below next_page_id_, in the order they are reused. */
+    std::set<page_id_t> free_pages_;
+    /** The id the class extends the file with once free_pages_ is empty; it is skipped if already allocated. */
+    page_id_t next_page_id_;
+  };
+
+  /** @return the allocation class of a stride and offset, set up from the bitmaps on first use */
+  AllocationClass *GetAllocationClass(uint32_t stride, uint32_t offset);
+
+  /** Carry out a request synchronously. @return false on an I/O error */
+  bool CompleteRequest(const DiskRequest &request);
+
+  /** @return the io_uring of the db file, set up on first use, or nullptr if io_uring is unavailable */
+  DiskIoRing *GetIoRing();
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // size of the log file, which only WriteLog appends to
+  int64_t log_size_{0};
+  // descriptor of the db file, shared by all page I/O; -1 once shut down
+  int db_fd_{-1};
+  bool direct_io_{false};
   std::string file_name_;
-  int num_flushes_;
-  int num_writes_;
-  bool flush_log_;
-  std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  std::once_flag io_ring_once_;
+  std::unique_ptr<DiskIoRing> io_ring_;
+
+  /** Protects allocated_pages_, dirty_bitmaps_, allocation_classes_, extents_ and extent_cursors_. */
+  std::mutex allocation_latch_;
+  /** One bit per page, set while the page is allocated. The words of a group are the contents of its bitmap page. */
+  std::vector<uint64_t> allocated_pages_;
+  /** Groups whose bitmap page changed since it was last written. */
+  std::set<int64_t> dirty_bitmaps_;
+  /** The allocation classes in use, by stride and offset. */
+  std::map<std::pair<uint32_t, uint32_t>, AllocationClass> allocation_classes_;
+  /** The extents handed out that may still have pages left to take. */
+  std::vector<std::shared_ptr<Extent>> extents_;
+  /** For each extent size in use, the lowest aligned run that may be free; no run of that size below it is free. */
+  std::map<size_t, page_id_t> extent_cursors_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_memory.h
+//
+// Identification: src/include/storage/disk/disk_manager_memory.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * How long a simulated device takes to serve a request. A request is done once its latency has passed and its bytes
+ * have been transferred; requests wait for each other only for the transfer, so many requests can be in flight at
+ * once but together they cannot exceed the bandwidth.
+ */
+struct DiskLatencyModel {
+  std::chrono::nanoseconds read_latency_{0};
+  std::chrono::nanoseconds write_latency_{0};
+  /** Bytes per second the device transfers, 0 for unlimited. */
+  uint64_t bandwidth_{0};
+
+  /** @return a model of a SATA flash drive: 100us reads, 30us writes into its cache, 500 MB/s */
+  static DiskLatencyModel Ssd() {
+    return {std::chrono::microseconds(100), std::chrono::microseconds(30), 500ULL * 1000 * 1000};
+  }
+
+  /** @return a model of a 7200 rpm disk doing random I/O: about 8ms to seek and rotate, 150 MB/s */
+  static DiskLatencyModel Hdd() {
+    return {std::chrono::milliseconds(8), std::chrono::milliseconds(8), 150ULL * 1000 * 1000};
+  }
+};
+
+/**
+ * DiskManagerMemory is a DiskManager that keeps pages and the log in memory instead of in files, for benchmarks and
+ * tests that must not depend on the file system. Pages are stored sparsely, so only pages that were written take up
+ * memory, until they are deallocated; a page that was never written reads as zeros. A DiskLatencyModel can make every
+ * page read and write take as long as it would on a simulated device, which keeps I/O costs reproducible and separate
+ * from CPU costs.
+ *
+ * Asynchronous requests are completed on the submitting thread, after the simulated delay.
+ */
+class DiskManagerMemory : public DiskManager {
+ public:
+  /**
+   * Creates a new in-memory disk manager.
+   * @param latency the delays of the simulated device, none by default
+   */
+  explicit DiskManagerMemory(DiskLatencyModel latency = {});
+
+  ~DiskManagerMemory() override = default;
+
+  void ShutDown() override {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) override;
+
+  void Sync() override {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) override;
+
+  void SubmitBatch(std::vector<DiskRequest> *requests) override;
+
+  void WriteLog(char *log_data, int size) override;
+
+  bool ReadLog(char *log_data, int size, int64_t offset) override;
+
+  /** Frees the page and the memory it takes. */
+  void DeallocatePage(page_id_t page_id) override;
+
+  /** @return the number of pages that were ever written */
+  size_t GetNumPages();
+
+ private:
+  /** Block until a transfer of the given size, started now, would be done on the simulated device. */
+  void Delay(std::chrono::nanoseconds latency, size_t bytes);
+
+  const DiskLatencyModel latency_;
+
+  /** Protects pages_; readers copy pages out under a shared lock. */
+  std::shared_mutex pages_latch_;
+  std::unordered_map<page_id_t, std::unique_ptr<char[]>> pages_;
+
+  /** Protects log_. */
+  std::mutex log_latch_;
+  std::vector<char> log_;
+
+  /** Protects device_free_. */
+  std::mutex device_latch_;
+  /** The time at which the simulated device finishes the transfers that were started so far. */
+  std::chrono::steady_clock::time_point device_free_;
+};
+
+}  // namespace bustub
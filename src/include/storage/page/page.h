@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -24,14 +29,25 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * In a buffer pool, a Page is only the frame descriptor: the page data lives in a separate, page-aligned arena. The
+ * descriptors are cache-line aligned and keep the fields that frame scans read on their first cache line, so that
+ * victim selection and flushes walk a dense array of descriptors instead of striding over the page data, and updates
+ * to the book-keeping never share a cache line with page data or with a neighbouring frame.
  */
-class Page {
+class alignas(64) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor for a page outside of a buffer pool. Allocates its own page data and zeros it out. */
+  Page() : owned_data_(new char[PAGE_SIZE]{}) { data_ = owned_data_.get(); }
+
+  /**
+   * Constructor for a buffer pool frame.
+   * @param data the frame's slot in the buffer pool's data arena, PAGE_SIZE bytes that are already zeroed
+   */
+  explicit Page(char *data) : data_(data) {}
 
   /** Default destructor. */
   ~Page() = default;
@@ -49,10 +65,16 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +82,28 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read. The page is read without latching it (and possibly without pinning it), and the read is
+   * only valid if OptimisticReadValidate() succeeds afterwards. Anything read in between may be torn, so it must be
+   * bounds-checked before it is used to index into the page.
+   * @param[out] version the version to validate against
+   * @return false if the page is write latched or being (re)loaded, in which case there is no point in reading it
+   */
+  inline bool OptimisticReadBegin(uint64_t *version) {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version returned by OptimisticReadBegin()
+   * @return true if the page was neither write latched nor replaced since the read began
+   */
+  inline bool OptimisticReadValidate(uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -78,16 +122,40 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
+  // The fields up to writeback_in_progress_ are read by every scan over the frames, and fit in one cache line.
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_{nullptr};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page. Hits pin and unpin without the buffer pool latch, so this is atomic. */
+  std::atomic<int> pin_count_ = 0;
+  /**
+   * Odd while the page is write latched or the frame is being given to another page, bumped to the next even value
+   * when that ends. Optimistic readers compare it before and after reading.
+   */
+  std::atomic<uint64_t> version_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /** True once the page has been fetched since it was read into this frame. Prefetches do not count. */
+  std::atomic<bool> fetched_ = false;
+  /**
+   * True while the buffer pool is writing out the frame's previous page or reading this page in. Requesters of the
+   * page pin the frame and then wait on io_cv_ until the I/O completes.
+   */
+  std::atomic<bool> io_in_progress_ = false;
+  /**
+   * True while the background writer or a bulk flush is writing the page out. The contents stay valid, so hits do not
+   * wait for it, but the frame cannot be evicted or deleted until the write completes.
+   */
+  std::atomic<bool> writeback_in_progress_ = false;
+  /** Page data of a page outside of a buffer pool. */
+  std::unique_ptr<char[]> owned_data_;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Protects the transitions of io_in_progress_ and writeback_in_progress_. */
+  std::mutex io_latch_;
+  /** Signalled when io_in_progress_ or writeback_in_progress_ becomes false. */
+  std::condition_variable io_cv_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,221 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard owns the pin on a page and unpins it exactly once, when the guard is dropped, destroyed or assigned
+ * over. Guards are move-only. A moved-from guard, or one created from a failed fetch, holds no page and is not valid.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over the pin on a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned page, may be nullptr
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  /** Move the pin out of that guard, which is left invalid. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Unpin the page held by this guard, then move the pin out of that guard. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  /** Unpins the page if the guard still holds it. */
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now. The guard is invalid afterwards, and dropping it again does nothing. */
+  void Drop();
+
+  /**
+   * Read latch the page and hand the pin over to a ReadPageGuard. This guard is invalid afterwards.
+   * @return a guard holding the pin and the read latch
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Write latch the page and hand the pin over to a WritePageGuard. This guard is invalid afterwards.
+   * @return a guard holding the pin and the write latch
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page */
+  char *GetData() { return page_->GetData(); }
+
+  /** Have the page unpinned as dirty. */
+  void SetDirty() { is_dirty_ = true; }
+
+  /**
+   * View the guarded page as T. Page subclasses such as TablePage wrap the frame itself, any other type is laid over
+   * the page data.
+   * @return the guarded page as T
+   */
+  template <class T>
+  T *As() {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  /**
+   * View the guarded page as T for writing, which has the page unpinned as dirty.
+   * @return the guarded page as T
+   */
+  template <class T>
+  T *AsMut() {
+    is_dirty_ = true;
+    return As<T>();
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns the pin and the read latch on a page, and releases both exactly once, latch first.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over the pin and the read latch on a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned and read latched page, may be nullptr
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  /** Move the pin and latch out of that guard, which is left invalid. */
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Release the page held by this guard, then move the pin and latch out of that guard. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  /** Unlatches and unpins the page if the guard still holds it. */
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now. The guard is invalid afterwards, and dropping it again does nothing. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  char *GetData() { return guard_.GetData(); }
+
+  /** @return the guarded page as T, see BasicPageGuard::As() */
+  template <class T>
+  T *As() {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns the pin and the write latch on a page, and releases both exactly once, latch first.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over the pin and the write latch on a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned and write latched page, may be nullptr
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  /** Move the pin and latch out of that guard, which is left invalid. */
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Release the page held by this guard, then move the pin and latch out of that guard. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  /** Unlatches and unpins the page if the guard still holds it. */
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now. The guard is invalid afterwards, and dropping it again does nothing. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  char *GetData() { return guard_.GetData(); }
+
+  /** Have the page unpinned as dirty. */
+  void SetDirty() { guard_.SetDirty(); }
+
+  /** @return the guarded page as T, see BasicPageGuard::As() */
+  template <class T>
+  T *As() {
+    return guard_.As<T>();
+  }
+
+  /** @return the guarded page as T, and have it unpinned as dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <memory>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -22,7 +24,8 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages. New pages are allocated from the table's own extents, so the list is
+ * mostly made of runs of adjacent pages that a scan reads sequentially.
  */
 class TableHeap {
   friend class TableIterator;
@@ -99,8 +102,12 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy if set, the pages the scan reads in are confined to the strategy's ring of frames
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -109,10 +116,25 @@ class TableHeap {
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
  private:
+  /** @return the pages a scan keeps read ahead, TABLE_HEAP_READAHEAD but never more than a quarter of the pool */
+  size_t ReadAheadSize();
+
+  /**
+   * Issue read-ahead for the pages of a scan: page_id and the pages after it in the page chain are prefetched in the
+   * background. Each page's successor is only known once the page is in memory, so the prefetch threads follow the
+   * chain themselves and the scan never waits for it.
+   * @param page_id the first page to read ahead, may be INVALID_PAGE_ID
+   * @param num_pages the number of pages to read ahead
+   * @return the read-ahead, where the prefetch threads record the page after its last page once they reach it
+   */
+  std::shared_ptr<ReadAheadWindow> ReadAhead(page_id_t page_id, size_t num_pages);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  /** The extents new pages of this table are created in. */
+  Segment segment_;
 };
 
 }  // namespace bustub
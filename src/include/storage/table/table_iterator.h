@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -22,6 +25,19 @@ namespace bustub {
 
 class TableHeap;
 
+/** How far a scan's read-ahead got, recorded by the prefetch threads as they follow the page chain. */
+struct ReadAheadWindow {
+  /**
+   * The page the prefetch threads read next, or once done_ is set, the page after the last page read ahead.
+   * INVALID_PAGE_ID at the end of the table.
+   */
+  std::atomic<page_id_t> next_page_id_{INVALID_PAGE_ID};
+  /** Set once the prefetch threads read the last page of the window. */
+  std::atomic<bool> done_{false};
+  /** Set by the scan to stop the prefetch threads from following the chain any further. */
+  std::atomic<bool> cancelled_{false};
+};
+
 /**
  * TableIterator enables the sequential scan of a TableHeap.
  */
@@ -29,10 +45,16 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr,
+                std::shared_ptr<ReadAheadWindow> read_ahead = nullptr, size_t read_ahead_pages = 0);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_(other.read_ahead_),
+        pages_until_read_ahead_(other.pages_until_read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,6 +74,9 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_ = other.read_ahead_;
+    pages_until_read_ahead_ = other.pages_until_read_ahead_;
     return *this;
   }
 
@@ -59,6 +84,12 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The scan's buffer access strategy, not owned. May be null. */
+  BufferAccessStrategy *strategy_;
+  /** The scan's latest read-ahead, null if the scan reads no pages ahead. */
+  std::shared_ptr<ReadAheadWindow> read_ahead_;
+  /** Pages left to scan before the next read-ahead request is issued. */
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
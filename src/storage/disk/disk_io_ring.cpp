@@ -0,0 +1,281 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_io_ring.cpp
+//
+// Identification: src/storage/disk/disk_io_ring.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_io_ring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BUSTUB_HAVE_IO_URING
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+DiskIoRing::DiskIoRing(int fd, offset_fn page_offset, unsigned queue_depth, fallback_fn fallback)
+    : fd_(fd), page_offset_(page_offset), fallback_(std::move(fallback)) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (ring_fd_ < 0) {
+    LOG_DEBUG("io_uring is unavailable, page I/O stays synchronous");
+    ring_fd_ = -1;
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  // newer kernels map both rings with one call
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    Close();
+    return;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      Close();
+      return;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = nullptr;
+    Close();
+    return;
+  }
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  sq_entries_ = params.sq_entries;
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  cq_entries_ = params.cq_entries;
+  reaper_ = std::thread(&DiskIoRing::RunReaper, this);
+}
+
+DiskIoRing::~DiskIoRing() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock latch(latch_);
+    completed_cv_.wait(latch, [this] { return in_flight_.empty(); });
+    // Completions can arrive in any order, so the no-op that stops the reaper is only sent once the ring is empty.
+    Prepare(nullptr);
+    if (!Enter(1) && !reaper_exited_) {
+      // nothing can wake the reaper any more, so it keeps the ring, which stays mapped
+      LOG_DEBUG("io_uring ring could not be stopped");
+      reaper_.detach();
+      return;
+    }
+  }
+  reaper_.join();
+  Close();
+}
+
+void DiskIoRing::Close() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  sqes_ = cq_ring_ = sq_ring_ = nullptr;
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+void DiskIoRing::Submit(std::vector<DiskRequest> *requests) {
+  std::unique_lock latch(latch_);
+  size_t next = 0;
+  while (next < requests->size()) {
+    // more requests in flight than the completion queue holds could overflow it
+    completed_cv_.wait(latch, [this] { return in_flight_.size() < cq_entries_ || broken_; });
+    if (broken_) {
+      break;
+    }
+    const auto count = static_cast<unsigned>(std::min<size_t>(
+        {requests->size() - next, sq_entries_, cq_entries_ - in_flight_.size()}));
+    for (unsigned i = 0; i < count; i++) {
+      auto *request = new DiskRequest(std::move((*requests)[next++]));
+      in_flight_.insert(request);
+      Prepare(request);
+    }
+    Enter(count);
+  }
+  latch.unlock();
+  // a broken ring takes no more requests
+  for (; next < requests->size(); next++) {
+    (*requests)[next].callback_.set_value(fallback_((*requests)[next]));
+  }
+  requests->clear();
+}
+
+void DiskIoRing::Prepare(DiskRequest *request) {
+  // only submitters move the tail, and they hold latch_
+  const unsigned tail = *sq_tail_;
+  const unsigned index = tail & sq_mask_;
+  auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = fd_;
+    sqe->off = page_offset_(request->page_id_);
+    sqe->addr = reinterpret_cast<uint64_t>(request->data_);
+    sqe->len = PAGE_SIZE;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool DiskIoRing::Enter(unsigned count) {
+  while (count > 0) {
+    const auto submitted = syscall(__NR_io_uring_enter, ring_fd_, count, 0, 0, nullptr, 0);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      LOG_DEBUG("io_uring_enter failed, page I/O falls back to synchronous");
+      // The kernel takes entries in order, so the last count entries were never submitted and no completion will
+      // arrive for them. Take them back before a later submission could overwrite them.
+      const unsigned tail = *sq_tail_ - count;
+      for (unsigned i = 0; i < count; i++) {
+        const auto *sqe = static_cast<io_uring_sqe *>(sqes_) + ((tail + i) & sq_mask_);
+        auto *request = reinterpret_cast<DiskRequest *>(sqe->user_data);
+        if (request != nullptr) {
+          in_flight_.erase(request);
+          request->callback_.set_value(fallback_(*request));
+          delete request;
+        }
+      }
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      broken_ = true;
+      completed_cv_.notify_all();
+      return false;
+    }
+    count -= submitted;
+  }
+  return true;
+}
+
+void DiskIoRing::RunReaper() {
+  while (true) {
+    if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+      // No completion can be waited for any more, so the requests in flight are completed synchronously. One the
+      // kernel still works on is then carried out twice, which writes or reads the same data again.
+      LOG_DEBUG("io_uring_enter failed while waiting for completions, page I/O falls back to synchronous");
+      std::unique_lock latch(latch_);
+      std::unordered_set<DiskRequest *> requests = std::move(in_flight_);
+      in_flight_.clear();
+      broken_ = true;
+      reaper_exited_ = true;
+      latch.unlock();
+      for (auto *request : requests) {
+        request->callback_.set_value(fallback_(*request));
+        delete request;
+      }
+      latch.lock();
+      completed_cv_.notify_all();
+      return;
+    }
+    // only this thread moves the head
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    std::vector<std::pair<DiskRequest *, int>> reaped;
+    bool stop = false;
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = static_cast<io_uring_cqe *>(cqes_)[head & cq_mask_];
+      auto *request = reinterpret_cast<DiskRequest *>(cqe.user_data);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      reaped.emplace_back(request, cqe.res);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    for (auto [request, res] : reaped) {
+      // errors and short transfers are retried synchronously, which also zero-fills a read past the end of the file
+      const bool succeeded = res == PAGE_SIZE || fallback_(*request);
+      request->callback_.set_value(succeeded);
+    }
+    if (!reaped.empty()) {
+      std::scoped_lock latch(latch_);
+      for (auto [request, res] : reaped) {
+        in_flight_.erase(request);
+        delete request;
+      }
+      completed_cv_.notify_all();
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+#else
+
+DiskIoRing::DiskIoRing(int fd, offset_fn page_offset, unsigned queue_depth, fallback_fn fallback)
+    : fd_(fd), page_offset_(page_offset), fallback_(std::move(fallback)) {}
+
+DiskIoRing::~DiskIoRing() = default;
+
+void DiskIoRing::Submit(std::vector<DiskRequest> *requests) {
+  for (auto &request : *requests) {
+    request.callback_.set_value(fallback_(request));
+  }
+  requests->clear();
+}
+
+void DiskIoRing::RunReaper() {}
+
+void DiskIoRing::Prepare(DiskRequest *request) {}
+
+bool DiskIoRing::Enter(unsigned count) { return true; }
+
+void DiskIoRing::Close() {}
+
+#endif
+
+}  // namespace bustub
@@ -10,8 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
@@ -26,12 +32,201 @@ namespace bustub {
 
 static char *buffer_used;
 
+/**
+ * pwrite the whole buffer, retrying after interrupts and short writes
+ * @return false on an I/O error
+ */
+static bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+/**
+ * pread into the whole buffer, retrying after interrupts and short reads, until the end of the file. With O_DIRECT a
+ * short read already means the end of the file, and retrying at the unaligned offset after it would fail.
+ * @return the number of bytes read, or -1 on an I/O error
+ */
+static ssize_t ReadFully(int fd, char *data, size_t size, off_t offset, bool direct) {
+  size_t total = 0;
+  while (total < size) {
+    ssize_t read_count = pread(fd, data + total, size - total, offset + total);
+    if (read_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    if (read_count == 0) {
+      break;
+    }
+    total += read_count;
+    if (direct) {
+      break;
+    }
+  }
+  return total;
+}
+
+/** @return true if a buffer is aligned well enough for O_DIRECT */
+static bool IsDirectIoAligned(const char *data) { return reinterpret_cast<uintptr_t>(data) % PAGE_SIZE == 0; }
+
+/** @return a page-aligned buffer of this thread, to bounce unaligned pages through under O_DIRECT */
+static char *BounceBuffer() {
+  alignas(PAGE_SIZE) static thread_local char bounce[PAGE_SIZE];
+  return bounce;
+}
+
+/**
+ * Write one page at its place in the file
+ * @return false on an I/O error
+ */
+static bool WritePageTo(int fd, page_id_t page_id, const char *page_data, bool direct) {
+  if (direct && !IsDirectIoAligned(page_data)) {
+    char *bounce = BounceBuffer();
+    memcpy(bounce, page_data, PAGE_SIZE);
+    page_data = bounce;
+  }
+  if (!WriteFully(fd, page_data, PAGE_SIZE, DiskManager::PageOffset(page_id))) {
+    LOG_DEBUG("I/O error while writing");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Read one page from its place in the file, zero-filling whatever lies past the end of the file
+ * @return false on an I/O error
+ */
+static bool ReadPageFrom(int fd, page_id_t page_id, char *page_data, bool direct) {
+  if (direct && !IsDirectIoAligned(page_data)) {
+    char *bounce = BounceBuffer();
+    bool read = ReadPageFrom(fd, page_id, bounce, direct);
+    memcpy(page_data, bounce, PAGE_SIZE);
+    return read;
+  }
+  ssize_t read_count = ReadFully(fd, page_data, PAGE_SIZE, DiskManager::PageOffset(page_id), direct);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+  return true;
+}
+
+/**
+ * preadv/pwritev a run of adjacent pages, retrying after interrupts and short transfers. A read stops at the end of
+ * the file, or with O_DIRECT after a short read, and the rest of the run reads as zeros.
+ * @param iov the pages' buffers, consumed by the transfer
+ * @return false on an I/O error
+ */
+static bool TransferRun(int fd, bool is_write, std::vector<iovec> *iov, off_t offset, bool direct) {
+  size_t next = 0;
+  while (next < iov->size()) {
+    const auto count = std::min<size_t>(iov->size() - next, IOV_MAX);
+    size_t requested = 0;
+    for (size_t i = next; i < next + count; i++) {
+      requested += (*iov)[i].iov_len;
+    }
+    ssize_t transferred = is_write ? pwritev(fd, &(*iov)[next], static_cast<int>(count), offset)
+                                   : preadv(fd, &(*iov)[next], static_cast<int>(count), offset);
+    if (transferred < 0 && errno == EINTR) {
+      continue;
+    }
+    if (transferred < 0 || (is_write && transferred == 0)) {
+      return false;
+    }
+    const bool at_end = !is_write && (transferred == 0 || (direct && static_cast<size_t>(transferred) < requested));
+    offset += transferred;
+    // step over the buffers that are done and into one that was transferred partially
+    while (transferred > 0) {
+      iovec &buffer = (*iov)[next];
+      const auto step = std::min<size_t>(transferred, buffer.iov_len);
+      buffer.iov_base = static_cast<char *>(buffer.iov_base) + step;
+      buffer.iov_len -= step;
+      transferred -= step;
+      if (buffer.iov_len == 0) {
+        next++;
+      }
+    }
+    if (at_end) {
+      for (; next < iov->size(); next++) {
+        memset((*iov)[next].iov_base, 0, (*iov)[next].iov_len);
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Read or write a list of pages in page id order, with one vectored call per run of adjacent pages
+ * @return false if any page could not be transferred
+ */
+static bool TransferPages(int fd, bool is_write, std::vector<std::pair<page_id_t, char *>> pages, bool direct) {
+  // a stable sort keeps the last of several writes to the same page last
+  std::stable_sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  bool succeeded = true;
+  std::vector<iovec> run;
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  auto transfer_run = [&] {
+    if (!run.empty()) {
+      succeeded = TransferRun(fd, is_write, &run, DiskManager::PageOffset(first_page_id), direct) && succeeded;
+      run.clear();
+    }
+  };
+  for (const auto &[page_id, data] : pages) {
+    // the kernel rejects unaligned buffers under O_DIRECT; those pages go through the bounce buffer one by one
+    if (direct && !IsDirectIoAligned(data)) {
+      transfer_run();
+      succeeded = (is_write ? WritePageTo(fd, page_id, data, direct) : ReadPageFrom(fd, page_id, data, direct)) &&
+                  succeeded;
+      continue;
+    }
+    // a run ends at a gap between page ids, and where a bitmap page lies between two groups of pages
+    if (!run.empty() && (page_id != first_page_id + static_cast<page_id_t>(run.size()) ||
+                         page_id % DiskManager::PAGES_PER_BITMAP == 0)) {
+      transfer_run();
+    }
+    if (run.empty()) {
+      first_page_id = page_id;
+    }
+    run.push_back({data, PAGE_SIZE});
+  }
+  transfer_run();
+  return succeeded;
+}
+
+/** The start of the file header, see DiskManager::FILE_HEADER_SIZE; the rest of the header page is zeros. */
+struct DiskFileHeader {
+  char magic_[8];
+  uint32_t format_version_;
+  uint32_t page_size_;
+  uint32_t page_id_size_;
+  uint32_t lsn_size_;
+};
+
+static constexpr char DB_FILE_MAGIC[8] = {'B', 'U', 'S', 'T', 'U', 'B', 'D', 'B'};
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
+    : num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr), file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -53,30 +248,84 @@ DiskManager::DiskManager(const std::string &db_file)
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // the log only grows through WriteLog, so its size is tracked from here on instead of asking the file system
+  log_size_ = GetFileSize(log_name_);
+
+  // create the file if it does not exist
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    // some file systems (e.g. tmpfs) do not support O_DIRECT
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT is not supported for the db file, falling back to buffered I/O");
     }
   }
+  if (!direct_io_) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  InitFileHeader();
+  LoadBitmaps();
   buffer_used = nullptr;
 }
 
+void DiskManager::InitFileHeader() {
+  alignas(PAGE_SIZE) char header_page[FILE_HEADER_SIZE] = {0};
+  DiskFileHeader expected{{}, FORMAT_VERSION, PAGE_SIZE, sizeof(page_id_t), sizeof(lsn_t)};
+  memcpy(expected.magic_, DB_FILE_MAGIC, sizeof(DB_FILE_MAGIC));
+
+  ssize_t read_count = ReadFully(db_fd_, header_page, FILE_HEADER_SIZE, 0, direct_io_);
+  if (read_count == 0) {
+    // a new file
+    memcpy(header_page, &expected, sizeof(expected));
+    if (WriteFully(db_fd_, header_page, FILE_HEADER_SIZE, 0) && fdatasync(db_fd_) == 0) {
+      return;
+    }
+    close(db_fd_);
+    db_fd_ = -1;
+    throw Exception("can't write the header of db file " + file_name_);
+  }
+
+  DiskFileHeader header;
+  memcpy(&header, header_page, sizeof(header));
+  std::string error;
+  if (read_count < static_cast<ssize_t>(sizeof(header)) ||
+      memcmp(header.magic_, DB_FILE_MAGIC, sizeof(DB_FILE_MAGIC)) != 0) {
+    error = file_name_ + " is not a database file";
+  } else if (header.format_version_ != FORMAT_VERSION) {
+    error = file_name_ + " has format version " + std::to_string(header.format_version_) + ", expected " +
+            std::to_string(FORMAT_VERSION);
+  } else if (memcmp(&header, &expected, sizeof(header)) != 0) {
+    error = file_name_ + " was written with a different page size, page id width or LSN width";
+  }
+  if (!error.empty()) {
+    close(db_fd_);
+    db_fd_ = -1;
+    throw Exception(error);
+  }
+}
+
+DiskManager::~DiskManager() {
+  io_ring_.reset();
+  if (db_fd_ >= 0) {
+    std::scoped_lock latch(allocation_latch_);
+    WriteBitmaps();
+    close(db_fd_);
+  }
+}
+
 /**
- * Close all file streams
+ * Sync and close all files
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  // wait for asynchronous requests before closing the file they go to
+  io_ring_.reset();
+  if (db_fd_ >= 0) {
+    Sync();
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
@@ -85,48 +334,347 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  WritePageTo(db_fd_, page_id, page_data, direct_io_);
+}
+
+/**
+ * Write a list of pages into disk file, merging adjacent pages into single writes
+ */
+void DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  num_writes_ += pages.size();
+  // the buffers are only read from
+  std::vector<std::pair<page_id_t, char *>> buffers;
+  buffers.reserve(pages.size());
+  for (const auto &[page_id, page_data] : pages) {
+    buffers.emplace_back(page_id, const_cast<char *>(page_data));
+  }
+  if (!TransferPages(db_fd_, true, std::move(buffers), direct_io_)) {
     LOG_DEBUG("I/O error while writing");
-    return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Sync the completed writes to the disk file
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
+void DiskManager::Sync() {
+  bool written;
+  {
+    std::scoped_lock latch(allocation_latch_);
+    written = WriteBitmaps();
+  }
+  if (!written || fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+}
+
+/**
+ * Allocate the lowest free page of an allocation class
+ */
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t offset) {
+  std::scoped_lock latch(allocation_latch_);
+  AllocationClass *allocation_class = GetAllocationClass(stride, offset);
+  page_id_t page_id;
+  if (!allocation_class->free_pages_.empty()) {
+    page_id = *allocation_class->free_pages_.begin();
+    allocation_class->free_pages_.erase(allocation_class->free_pages_.begin());
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
+    // a class with another stride may have taken ids past the end of this class's pages
+    while (TestAllocated(allocation_class->next_page_id_)) {
+      allocation_class->next_page_id_ += stride;
+    }
+    page_id = allocation_class->next_page_id_;
+    allocation_class->next_page_id_ += stride;
+  }
+  TakePage(page_id);
+  return page_id;
+}
+
+/**
+ * Allocate an aligned run of free pages
+ */
+std::shared_ptr<Extent> DiskManager::AllocateExtent(size_t num_pages) {
+  std::scoped_lock latch(allocation_latch_);
+  ReleaseExtents();
+  const auto extent_size = static_cast<page_id_t>(num_pages);
+  page_id_t &cursor = extent_cursors_[num_pages];
+  page_id_t first_page_id = cursor;
+  while (true) {
+    page_id_t page_id = first_page_id;
+    while (page_id < first_page_id + extent_size && !TestAllocated(page_id)) {
+      page_id++;
+    }
+    if (page_id == first_page_id + extent_size) {
+      break;
+    }
+    first_page_id += extent_size;
+  }
+  cursor = first_page_id + extent_size;
+  for (page_id_t page_id = first_page_id; page_id < first_page_id + extent_size; page_id++) {
+    TakePage(page_id);
+  }
+  extents_.push_back(std::make_shared<Extent>(first_page_id, first_page_id + extent_size));
+  return extents_.back();
+}
+
+void DiskManager::TakePage(page_id_t page_id) {
+  SetAllocated(page_id, true);
+  for (auto &[key, allocation_class] : allocation_classes_) {
+    allocation_class.free_pages_.erase(page_id);
+  }
+}
+
+/**
+ * Free a page and let the file system drop its blocks
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  {
+    std::scoped_lock latch(allocation_latch_);
+    if (!TestAllocated(page_id)) {
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    FreePage(page_id);
+  }
+#ifdef FALLOC_FL_PUNCH_HOLE
+  // the file keeps its size, so the pages after the freed one stay where they are
+  if (db_fd_ >= 0 &&
+      fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, PageOffset(page_id), PAGE_SIZE) != 0 &&
+      errno != EOPNOTSUPP) {
+    LOG_DEBUG("I/O error while freeing a page");
+  }
+#endif
+}
+
+void DiskManager::FreePage(page_id_t page_id) {
+  SetAllocated(page_id, false);
+  for (auto &[key, allocation_class] : allocation_classes_) {
+    if (page_id % key.first == key.second && page_id < allocation_class.next_page_id_) {
+      allocation_class.free_pages_.insert(page_id);
+    }
+  }
+  for (auto &[extent_size, cursor] : extent_cursors_) {
+    cursor = std::min(cursor, static_cast<page_id_t>(page_id - page_id % extent_size));
+  }
+}
+
+void DiskManager::ReleaseExtents() {
+  auto released = std::stable_partition(extents_.begin(), extents_.end(), [](const std::shared_ptr<Extent> &extent) {
+    return extent.use_count() > 1 && extent->next_page_id_.load() != extent->end_page_id_;
+  });
+  for (auto extent = released; extent != extents_.end(); ++extent) {
+    // the pages taken since the last write are written once the extent no longer masks them
+    for (int64_t group = (*extent)->first_page_id_ / PAGES_PER_BITMAP;
+         group <= ((*extent)->end_page_id_ - 1) / PAGES_PER_BITMAP; group++) {
+      dirty_bitmaps_.insert(group);
+    }
+    for (page_id_t page_id = (*extent)->next_page_id_.load(); page_id < (*extent)->end_page_id_; page_id++) {
+      FreePage(page_id);
+    }
+  }
+  extents_.erase(released, extents_.end());
+}
+
+/**
+ * Check whether a page is allocated
+ */
+bool DiskManager::IsPageAllocated(page_id_t page_id) {
+  std::scoped_lock latch(allocation_latch_);
+  return TestAllocated(page_id);
+}
+
+bool DiskManager::TestAllocated(page_id_t page_id) const {
+  const auto word = static_cast<size_t>(page_id) / 64;
+  return word < allocated_pages_.size() && (allocated_pages_[word] >> (page_id % 64) & 1) != 0;
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  const auto word = static_cast<size_t>(page_id) / 64;
+  if (word >= allocated_pages_.size()) {
+    // grow by whole groups, so that a group's words can always be copied into its bitmap page
+    const size_t group_words = PAGES_PER_BITMAP / 64;
+    allocated_pages_.resize((word / group_words + 1) * group_words, 0);
+  }
+  if (allocated) {
+    allocated_pages_[word] |= uint64_t{1} << (page_id % 64);
+  } else {
+    allocated_pages_[word] &= ~(uint64_t{1} << (page_id % 64));
+  }
+  dirty_bitmaps_.insert(page_id / PAGES_PER_BITMAP);
+}
+
+DiskManager::AllocationClass *DiskManager::GetAllocationClass(uint32_t stride, uint32_t offset) {
+  auto [allocation_class, inserted] = allocation_classes_.try_emplace({stride, offset});
+  if (inserted) {
+    // ids below the last allocated page are reused before the file is extended past it
+    auto end = static_cast<page_id_t>(allocated_pages_.size() * 64);
+    while (end > 0 && !TestAllocated(end - 1)) {
+      end--;
+    }
+    page_id_t page_id = static_cast<page_id_t>(offset);
+    for (; page_id < end; page_id += stride) {
+      if (!TestAllocated(page_id)) {
+        allocation_class->second.free_pages_.insert(page_id);
+      }
+    }
+    allocation_class->second.next_page_id_ = page_id;
+  }
+  return &allocation_class->second;
+}
+
+void DiskManager::LoadBitmaps() {
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't read the size of db file " + file_name_);
+  }
+  const int64_t group_size = (PAGES_PER_BITMAP + 1) * PAGE_SIZE;
+  const int64_t groups = (stat_buf.st_size - FILE_HEADER_SIZE + group_size - 1) / group_size;
+  const size_t group_words = PAGES_PER_BITMAP / 64;
+  alignas(PAGE_SIZE) char bitmap_page[PAGE_SIZE];
+  for (int64_t group = 0; group < groups; group++) {
+    ssize_t read_count = ReadFully(db_fd_, bitmap_page, PAGE_SIZE, BitmapOffset(group), direct_io_);
+    if (read_count < 0) {
+      throw Exception("can't read the page bitmaps of db file " + file_name_);
+    }
+    memset(bitmap_page + read_count, 0, PAGE_SIZE - read_count);
+    allocated_pages_.resize((group + 1) * group_words);
+    memcpy(&allocated_pages_[group * group_words], bitmap_page, PAGE_SIZE);
+  }
+  // trailing groups without allocated pages, e.g. of pages written without being allocated, take no memory
+  while (!allocated_pages_.empty() &&
+         std::all_of(allocated_pages_.end() - group_words, allocated_pages_.end(), [](uint64_t w) { return w == 0; })) {
+    allocated_pages_.resize(allocated_pages_.size() - group_words);
+  }
+}
+
+bool DiskManager::WriteBitmaps() {
+  if (db_fd_ < 0) {
+    dirty_bitmaps_.clear();
+    return true;
+  }
+  ReleaseExtents();
+  // the pages taken from an extent since the last write are only known from the extent itself
+  for (auto &extent : extents_) {
+    const page_id_t next_page_id = extent->next_page_id_.load();
+    if (next_page_id != extent->written_next_page_id_) {
+      for (int64_t group = extent->first_page_id_ / PAGES_PER_BITMAP;
+           group <= (extent->end_page_id_ - 1) / PAGES_PER_BITMAP; group++) {
+        dirty_bitmaps_.insert(group);
+      }
+      extent->written_next_page_id_ = next_page_id;
+    }
+  }
+  const size_t group_words = PAGES_PER_BITMAP / 64;
+  alignas(PAGE_SIZE) char bitmap_page[PAGE_SIZE];
+  auto *bitmap_words = reinterpret_cast<uint64_t *>(bitmap_page);
+  for (auto group = dirty_bitmaps_.begin(); group != dirty_bitmaps_.end(); group = dirty_bitmaps_.erase(group)) {
+    memcpy(bitmap_page, &allocated_pages_[*group * group_words], PAGE_SIZE);
+    // the pages of an extent that were not taken yet are not allocated on disk
+    const auto group_begin = static_cast<page_id_t>(*group * PAGES_PER_BITMAP);
+    const auto group_end = static_cast<page_id_t>(group_begin + PAGES_PER_BITMAP);
+    for (const auto &extent : extents_) {
+      for (page_id_t page_id = std::max(extent->written_next_page_id_, group_begin);
+           page_id < std::min(extent->end_page_id_, group_end); page_id++) {
+        bitmap_words[(page_id - group_begin) / 64] &= ~(uint64_t{1} << (page_id % 64));
+      }
+    }
+    if (!WriteFully(db_fd_, bitmap_page, PAGE_SIZE, BitmapOffset(*group))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Read the contents of the specified page into the given memory area
+ */
+void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  ReadPageFrom(db_fd_, page_id, page_data, direct_io_);
+}
+
+/**
+ * Read a list of pages into the given memory areas, merging adjacent pages into single reads
+ */
+void DiskManager::ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) {
+  if (!TransferPages(db_fd_, false, pages, direct_io_)) {
+    LOG_DEBUG("I/O error while reading");
+  }
+}
+
+/**
+ * Carry out a read or write synchronously, as WritePage and ReadPage do
+ */
+bool DiskManager::CompleteRequest(const DiskRequest &request) {
+  if (request.is_write_) {
+    return WritePageTo(db_fd_, request.page_id_, request.data_, direct_io_);
+  }
+  return ReadPageFrom(db_fd_, request.page_id_, request.data_, direct_io_);
+}
+
+/**
+ * Start an asynchronous read of the specified page
+ */
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  std::vector<DiskRequest> requests;
+  requests.push_back(DiskRequest{false, page_data, page_id, {}});
+  std::future<bool> done = requests.back().callback_.get_future();
+  SubmitBatch(&requests);
+  return done;
+}
+
+/**
+ * Start an asynchronous write of the specified page
+ */
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  std::vector<DiskRequest> requests;
+  // the request type is shared with reads, but a write only reads from the buffer
+  requests.push_back(DiskRequest{true, const_cast<char *>(page_data), page_id, {}});
+  std::future<bool> done = requests.back().callback_.get_future();
+  SubmitBatch(&requests);
+  return done;
+}
+
+/**
+ * Submit a batch of asynchronous requests, or carry them out right away without io_uring
+ */
+void DiskManager::SubmitBatch(std::vector<DiskRequest> *requests) {
+  for (const auto &request : *requests) {
+    if (request.is_write_) {
+      num_writes_ += 1;
+    }
+  }
+  DiskIoRing *io_ring = GetIoRing();
+  if (io_ring != nullptr) {
+    if (direct_io_) {
+      // the kernel rejects unaligned buffers under O_DIRECT; those go through a bounce buffer synchronously
+      auto unaligned = std::stable_partition(requests->begin(), requests->end(), [](const DiskRequest &request) {
+        return IsDirectIoAligned(request.data_);
+      });
+      for (auto request = unaligned; request != requests->end(); ++request) {
+        request->callback_.set_value(CompleteRequest(*request));
+      }
+      requests->erase(unaligned, requests->end());
     }
+    io_ring->Submit(requests);
+    return;
+  }
+  for (auto &request : *requests) {
+    request.callback_.set_value(CompleteRequest(request));
+  }
+  requests->clear();
+}
+
+DiskIoRing *DiskManager::GetIoRing() {
+  if (db_fd_ < 0) {
+    return nullptr;
   }
+  std::call_once(io_ring_once_, [this] {
+    io_ring_ = std::make_unique<DiskIoRing>(db_fd_, &DiskManager::PageOffset, DISK_IO_QUEUE_DEPTH,
+                                            [this](const DiskRequest &request) { return CompleteRequest(request); });
+    if (!io_ring_->IsAvailable()) {
+      io_ring_.reset();
+    }
+  });
+  return io_ring_.get();
 }
 
 /**
@@ -152,6 +700,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
   num_flushes_ += 1;
   // sequence write
   log_io_.write(log_data, size);
+  log_size_ += size;
 
   // check for I/O error
   if (log_io_.bad()) {
@@ -168,8 +717,8 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
+bool DiskManager::ReadLog(char *log_data, int size, int64_t offset) {
+  if (offset >= log_size_) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
@@ -209,10 +758,10 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
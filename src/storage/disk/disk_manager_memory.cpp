@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_memory.cpp
+//
+// Identification: src/storage/disk/disk_manager_memory.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+DiskManagerMemory::DiskManagerMemory(DiskLatencyModel latency) : latency_(latency) {}
+
+void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
+  num_writes_ += 1;
+  {
+    std::unique_lock latch(pages_latch_);
+    auto &page = pages_[page_id];
+    if (page == nullptr) {
+      page = std::make_unique<char[]>(PAGE_SIZE);
+    }
+    memcpy(page.get(), page_data, PAGE_SIZE);
+  }
+  Delay(latency_.write_latency_, PAGE_SIZE);
+}
+
+void DiskManagerMemory::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  num_writes_ += pages.size();
+  {
+    std::unique_lock latch(pages_latch_);
+    for (const auto &[page_id, page_data] : pages) {
+      auto &page = pages_[page_id];
+      if (page == nullptr) {
+        page = std::make_unique<char[]>(PAGE_SIZE);
+      }
+      memcpy(page.get(), page_data, PAGE_SIZE);
+    }
+  }
+  // the pages are written together, like the runs of a vectored write
+  Delay(latency_.write_latency_, pages.size() * PAGE_SIZE);
+}
+
+void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
+  {
+    std::shared_lock latch(pages_latch_);
+    auto page = pages_.find(page_id);
+    if (page == pages_.end()) {
+      memset(page_data, 0, PAGE_SIZE);
+    } else {
+      memcpy(page_data, page->second.get(), PAGE_SIZE);
+    }
+  }
+  Delay(latency_.read_latency_, PAGE_SIZE);
+}
+
+void DiskManagerMemory::ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) {
+  {
+    std::shared_lock latch(pages_latch_);
+    for (const auto &[page_id, page_data] : pages) {
+      auto page = pages_.find(page_id);
+      if (page == pages_.end()) {
+        memset(page_data, 0, PAGE_SIZE);
+      } else {
+        memcpy(page_data, page->second.get(), PAGE_SIZE);
+      }
+    }
+  }
+  Delay(latency_.read_latency_, pages.size() * PAGE_SIZE);
+}
+
+void DiskManagerMemory::SubmitBatch(std::vector<DiskRequest> *requests) {
+  // The requests of a batch are in flight together: they wait for the longest latency among them once, and for the
+  // transfer of all their bytes.
+  std::chrono::nanoseconds latency{0};
+  for (auto &request : *requests) {
+    if (request.is_write_) {
+      num_writes_ += 1;
+      std::unique_lock latch(pages_latch_);
+      auto &page = pages_[request.page_id_];
+      if (page == nullptr) {
+        page = std::make_unique<char[]>(PAGE_SIZE);
+      }
+      memcpy(page.get(), request.data_, PAGE_SIZE);
+      latency = std::max(latency, latency_.write_latency_);
+    } else {
+      std::shared_lock latch(pages_latch_);
+      auto page = pages_.find(request.page_id_);
+      if (page == pages_.end()) {
+        memset(request.data_, 0, PAGE_SIZE);
+      } else {
+        memcpy(request.data_, page->second.get(), PAGE_SIZE);
+      }
+      latency = std::max(latency, latency_.read_latency_);
+    }
+  }
+  Delay(latency, requests->size() * PAGE_SIZE);
+  for (auto &request : *requests) {
+    request.callback_.set_value(true);
+  }
+  requests->clear();
+}
+
+void DiskManagerMemory::WriteLog(char *log_data, int size) {
+  if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
+    return;
+  }
+  flush_log_ = true;
+  num_flushes_ += 1;
+  {
+    std::scoped_lock latch(log_latch_);
+    log_.insert(log_.end(), log_data, log_data + size);
+  }
+  Delay(latency_.write_latency_, size);
+  flush_log_ = false;
+}
+
+bool DiskManagerMemory::ReadLog(char *log_data, int size, int64_t offset) {
+  std::scoped_lock latch(log_latch_);
+  if (offset < 0 || static_cast<size_t>(offset) >= log_.size()) {
+    return false;
+  }
+  const size_t read_count = std::min(static_cast<size_t>(size), log_.size() - offset);
+  memcpy(log_data, log_.data() + offset, read_count);
+  // if the log ends before reading "size"
+  memset(log_data + read_count, 0, size - read_count);
+  return true;
+}
+
+void DiskManagerMemory::DeallocatePage(page_id_t page_id) {
+  DiskManager::DeallocatePage(page_id);
+  std::unique_lock latch(pages_latch_);
+  pages_.erase(page_id);
+}
+
+size_t DiskManagerMemory::GetNumPages() {
+  std::shared_lock latch(pages_latch_);
+  return pages_.size();
+}
+
+void DiskManagerMemory::Delay(std::chrono::nanoseconds latency, size_t bytes) {
+  if (latency.count() == 0 && latency_.bandwidth_ == 0) {
+    return;
+  }
+  auto done = std::chrono::steady_clock::now() + latency;
+  if (latency_.bandwidth_ > 0) {
+    const std::chrono::nanoseconds transfer(bytes * 1000000000ULL / latency_.bandwidth_);
+    std::scoped_lock latch(device_latch_);
+    // the transfer starts once the latency has passed and the device is done with the transfers ahead of it
+    device_free_ = std::max(device_free_, done) + transfer;
+    done = device_free_;
+  }
+  std::this_thread::sleep_until(done);
+}
+
+}  // namespace bustub
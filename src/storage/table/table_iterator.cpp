@@ -10,14 +10,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy,
+                             std::shared_ptr<ReadAheadWindow> read_ahead, size_t read_ahead_pages)
+    : table_heap_(table_heap),
+      tuple_(new Tuple(rid)),
+      txn_(txn),
+      strategy_(strategy),
+      read_ahead_(std::move(read_ahead)),
+      pages_until_read_ahead_(std::max<size_t>(read_ahead_pages / 2, 1)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,19 +43,33 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  ReadPageGuard cur_guard = buffer_pool_manager->FetchPageBasic(tuple_->rid_.GetPageId(), strategy_).UpgradeRead();
+  assert(cur_guard.IsValid());  // all pages are pinned
+  auto cur_page = cur_guard.As<TablePage>();
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      BasicPageGuard next_guard = buffer_pool_manager->FetchPageBasic(cur_page->GetNextPageId(), strategy_);
+      cur_guard.Drop();
+      cur_guard = next_guard.UpgradeRead();
+      cur_page = cur_guard.As<TablePage>();
+      // Keep the read-ahead window between half full and full: once the scan has used up half of it, read the next
+      // half ahead, starting where the last read-ahead ended. If the scan catches up with a read-ahead that fell
+      // behind or was dropped, that one is stopped and a full window is read ahead from the scan instead.
+      if (read_ahead_ != nullptr) {
+        const size_t half = std::max<size_t>(table_heap_->ReadAheadSize() / 2, 1);
+        pages_until_read_ahead_ -= pages_until_read_ahead_ > 0 ? 1 : 0;
+        if (!read_ahead_->done_.load() && read_ahead_->next_page_id_.load() == cur_page->GetTablePageId()) {
+          read_ahead_->cancelled_.store(true);
+          read_ahead_ = table_heap_->ReadAhead(cur_page->GetNextPageId(), 2 * half);
+          pages_until_read_ahead_ = half;
+        } else if (pages_until_read_ahead_ == 0 && read_ahead_->done_.load()) {
+          read_ahead_ = table_heap_->ReadAhead(read_ahead_->next_page_id_.load(), half);
+          pages_until_read_ahead_ = half;
+        }
+      }
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -59,8 +81,7 @@ TableIterator &TableIterator::operator++() {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  cur_guard.Drop();
   return *this;
 }
 
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(BufferAccessStrategyTest, RingTest) {
+  BufferAccessStrategy strategy(3);
+
+  // Scenario: nothing is retired until the ring wraps around.
+  strategy.RecordLoad(10);
+  EXPECT_EQ(INVALID_PAGE_ID, strategy.TakeRetiredPage());
+  strategy.RecordLoad(11);
+  strategy.RecordLoad(12);
+  EXPECT_EQ(INVALID_PAGE_ID, strategy.TakeRetiredPage());
+
+  // Scenario: from then on, every load retires the oldest page in the ring, once.
+  strategy.RecordLoad(13);
+  EXPECT_EQ(10, strategy.TakeRetiredPage());
+  EXPECT_EQ(INVALID_PAGE_ID, strategy.TakeRetiredPage());
+  strategy.RecordLoad(14);
+  EXPECT_EQ(11, strategy.TakeRetiredPage());
+}
+
+/**
+ * Creates a hot set of pages and a large table, warms up the hot set, scans the table and then reports how many hot
+ * pages were pushed out of the pool by the scan. Residency is detected by overwriting the hot pages on disk: a page
+ * that is still in the pool keeps its original contents.
+ */
+static int CountEvictedHotPages(BufferPoolManager *bpm, DiskManager *disk_manager, BufferAccessStrategy *strategy,
+                                int hot_pages, int table_pages) {
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < hot_pages + table_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  bpm->FlushAllPages();
+  std::vector<page_id_t> hot(page_ids.begin(), page_ids.begin() + hot_pages);
+  std::vector<page_id_t> table(page_ids.begin() + hot_pages, page_ids.end());
+  for (page_id_t page_id : hot) {
+    EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  for (page_id_t page_id : table) {
+    auto *page = strategy != nullptr ? bpm->FetchPage(page_id, strategy) : bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  char garbage[PAGE_SIZE] = "evicted";
+  for (page_id_t page_id : hot) {
+    disk_manager->WritePage(page_id, garbage);
+  }
+  int evicted = 0;
+  for (page_id_t page_id : hot) {
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    if (strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()) != 0) {
+      evicted++;
+    }
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  return evicted;
+}
+
+TEST(BufferAccessStrategyTest, ScanKeepsWorkingSetTest) {
+  const int hot_pages = 10;
+  const int table_pages = 100;
+
+  // Scenario: a plain scan flushes the hot set out of an LRU pool.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(20, disk_manager);
+  EXPECT_EQ(hot_pages, CountEvictedHotPages(bpm, disk_manager, nullptr, hot_pages, table_pages));
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+
+  // Scenario: a scan through a ring of four frames leaves the hot set alone.
+  disk_manager = new DiskManager("test.db");
+  bpm = new BufferPoolManagerInstance(20, disk_manager);
+  BufferAccessStrategy strategy(4);
+  EXPECT_EQ(0, CountEvictedHotPages(bpm, disk_manager, &strategy, hot_pages, table_pages));
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+TEST(BufferAccessStrategyTest, ParallelScanKeepsWorkingSetTest) {
+  const int hot_pages = 5;
+  const int table_pages = 100;
+
+  // Scenario: retired pages are routed back to the instance that holds them.
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(2, 10, disk_manager);
+  BufferAccessStrategy strategy(4);
+  EXPECT_EQ(0, CountEvictedHotPages(bpm, disk_manager, &strategy, hot_pages, table_pages));
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,249 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_benchmark_test.cpp
+//
+// Identification: test/buffer/buffer_pool_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Benchmarks are disabled by default. Run them with:
+//   ./test/buffer_pool_manager_benchmark_test --gtest_also_run_disabled_tests
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/**
+ * Serializes every call into a BufferPoolManagerInstance behind one mutex, the way the instance itself used to work
+ * before its page table was sharded. It is the baseline the scaling benchmark compares against.
+ */
+class GlobalLatchBufferPoolManager : public BufferPoolManager {
+ public:
+  GlobalLatchBufferPoolManager(size_t pool_size, DiskManager *disk_manager) : bpm_(pool_size, disk_manager) {}
+
+  size_t GetPoolSize() override { return bpm_.GetPoolSize(); }
+
+ protected:
+  Page *FetchPgImp(page_id_t page_id) override {
+    std::scoped_lock latch(latch_);
+    return bpm_.FetchPage(page_id);
+  }
+  bool UnpinPgImp(page_id_t page_id, bool is_dirty) override {
+    std::scoped_lock latch(latch_);
+    return bpm_.UnpinPage(page_id, is_dirty);
+  }
+  bool FlushPgImp(page_id_t page_id) override {
+    std::scoped_lock latch(latch_);
+    return bpm_.FlushPage(page_id);
+  }
+  Page *NewPgImp(page_id_t *page_id) override {
+    std::scoped_lock latch(latch_);
+    return bpm_.NewPage(page_id);
+  }
+  bool DeletePgImp(page_id_t page_id) override {
+    std::scoped_lock latch(latch_);
+    return bpm_.DeletePage(page_id);
+  }
+  void FlushAllPgsImp() override {
+    std::scoped_lock latch(latch_);
+    bpm_.FlushAllPages();
+  }
+
+ private:
+  BufferPoolManagerInstance bpm_;
+  std::mutex latch_;
+};
+
+/** Runs num_threads threads doing random fetch/unpin pairs on resident pages and returns the throughput in ops/ms. */
+static double RunHitWorkload(BufferPoolManager *bpm, int num_pages, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([=] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (int i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        EXPECT_NE(nullptr, page);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(num_threads) * ops_per_thread / elapsed;
+}
+
+static void FillPool(BufferPoolManager *bpm, int num_pages) {
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, DISABLED_HitScalingTest) {
+  const int num_pages = 1024;
+  const int ops_per_thread = 100000;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *sharded = new BufferPoolManagerInstance(num_pages, disk_manager);
+  auto *latched = new GlobalLatchBufferPoolManager(num_pages, disk_manager);
+  FillPool(sharded, num_pages);
+  FillPool(latched, num_pages);
+
+  printf("%8s %16s %16s\n", "threads", "sharded ops/ms", "latched ops/ms");
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    double sharded_tput = RunHitWorkload(sharded, num_pages, num_threads, ops_per_thread);
+    double latched_tput = RunHitWorkload(latched, num_pages, num_threads, ops_per_thread);
+    printf("%8d %16.1f %16.1f\n", num_threads, sharded_tput, latched_tput);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete sharded;
+  delete latched;
+  delete disk_manager;
+}
+
+/** Runs num_threads threads doing unpin/pin pairs on random frames and returns the throughput in ops/ms. */
+static double RunUnpinWorkload(Replacer *replacer, int num_frames, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([=] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<frame_id_t> dist(0, num_frames - 1);
+      for (int i = 0; i < ops_per_thread; i++) {
+        frame_id_t frame_id = dist(rng);
+        replacer->Unpin(frame_id);
+        replacer->Pin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(num_threads) * ops_per_thread / elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, DISABLED_ReplacerUnpinScalingTest) {
+  const int num_frames = 1024;
+  const int ops_per_thread = 100000;
+
+  printf("%8s %16s %16s\n", "threads", "clock ops/ms", "lru ops/ms");
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    ClockReplacer clock_replacer(num_frames);
+    LRUReplacer lru_replacer(num_frames);
+    double clock_tput = RunUnpinWorkload(&clock_replacer, num_frames, num_threads, ops_per_thread);
+    double lru_tput = RunUnpinWorkload(&lru_replacer, num_frames, num_threads, ops_per_thread);
+    printf("%8d %16.1f %16.1f\n", num_threads, clock_tput, lru_tput);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, DISABLED_MetadataScanTest) {
+  const int num_pages = 16384;
+  const int rounds = 100;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(num_pages, disk_manager);
+  FillPool(bpm, num_pages);
+  bpm->FlushAllPages();
+
+  // With every page clean, a flush and a hot set snapshot only walk the frame descriptors.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    bpm->FlushAllPages();
+  }
+  auto flush_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    EXPECT_EQ(num_pages, bpm->GetHotSet().size());
+  }
+  auto hot_set_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("%24s %16.2f\n", "clean flush ns/frame", flush_ns / rounds / num_pages);
+  printf("%24s %16.2f\n", "hot set ns/frame", hot_set_ns / rounds / num_pages);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * Runs num_threads threads that each create pages_per_thread pages, write them and unpin them dirty. Returns the
+ * throughput in pages/ms, and counts the pages every instance allocated.
+ */
+static double RunInsertWorkload(BufferPoolManager *bpm, int num_threads, int pages_per_thread,
+                                std::vector<std::atomic<int>> *per_instance) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([=] {
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+        bpm->UnpinPage(page_id, true);
+        (*per_instance)[page_id % per_instance->size()]++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(num_threads) * pages_per_thread / elapsed;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, DISABLED_ParallelInsertTest) {
+  const int num_instances = 8;
+  const int instance_pool_size = 128;
+  const int pages_per_thread = 4096;
+
+  // Every page that does not fit into the instance it was allocated on is written back, so a skewed allocation
+  // shows up both as a skewed page count per instance and as extra write-backs.
+  printf("%8s %12s %16s %16s %12s\n", "threads", "pages/ms", "min pages/inst", "max pages/inst", "writebacks");
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+    // pages go to memory, so that the numbers show the buffer pool rather than the file system
+    auto *disk_manager = new DiskManagerMemory();
+    auto *bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+    std::vector<std::atomic<int>> per_instance(num_instances);
+    double tput = RunInsertWorkload(bpm, num_threads, pages_per_thread, &per_instance);
+    auto [min_pages, max_pages] = std::minmax_element(per_instance.begin(), per_instance.end());
+    printf("%8d %12.1f %16d %16d %12lu\n", num_threads, tput, min_pages->load(), max_pages->load(),
+           bpm->GetStats().writebacks_);
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
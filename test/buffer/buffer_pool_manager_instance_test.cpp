@@ -11,9 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +147,587 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Check that concurrent hits and misses always return the page that was asked for
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+  const int num_threads = 8;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: create more pages than fit in the pool, stamping each one with its own id.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: threads fetch a mix of resident and evicted pages. Every fetch must see the right contents.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::default_random_engine rng(tid);
+      std::uniform_int_distribution<int> dist(0, num_pages - 1);
+      char expected[PAGE_SIZE];
+      for (int i = 0; i < 2000; ++i) {
+        page_id_t page_id = dist(rng) % (i % 2 == 0 ? 8 : num_pages);
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: every pin has been released, so the whole pool can be reused.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Check that a dirty page evicted by one thread is never read back stale by another
+TEST(BufferPoolManagerInstanceTest, ConcurrentDirtyEvictionTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_threads = 4;
+  const int pages_per_thread = 8;
+  const int rounds = 200;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_threads * pages_per_thread; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: every thread bumps a counter stored in its own pages. The pool holds a quarter of the pages, so dirty
+  // write-backs and reads of other pages are constantly in flight at the same time.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      for (int round = 0; round < rounds; ++round) {
+        page_id_t page_id = tid * pages_per_thread + round % pages_per_thread;
+        Page *page = nullptr;
+        while ((page = bpm->FetchPage(page_id)) == nullptr) {
+          std::this_thread::yield();
+        }
+        page->WLatch();
+        ++*reinterpret_cast<int *>(page->GetData());
+        page->WUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: no increment was lost to a stale read.
+  for (int i = 0; i < num_threads * pages_per_thread; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(rounds / pages_per_thread, *reinterpret_cast<int *>(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->StartBackgroundWriter(0.0, 0.5, std::chrono::milliseconds(10));
+
+  // Scenario: dirty every frame. The writer cleans them all in the background.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (int i = 0; i < 1000 && bpm->GetDirtyPageNum() > 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(0, bpm->GetDirtyPageNum());
+
+  // Scenario: the pages reached the disk without being evicted.
+  char data[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ(0, strcmp(data, ("page " + std::to_string(page_id)).c_str()));
+  }
+
+  // Scenario: with one page dirty again, new pages evict the clean ones first, so the dirty page stays resident.
+  auto *page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->UnpinPage(3, true));
+  bpm->StopBackgroundWriter();
+  bpm->StartBackgroundWriter(0.5, 1.0, std::chrono::seconds(60));
+  for (size_t i = 0; i < buffer_pool_size - 1; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(1, bpm->GetDirtyPageNum());
+  EXPECT_EQ(true, bpm->FlushPage(3));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: write twice as many pages as fit into the pool, so the first ones are evicted.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: prefetch some of the evicted pages. The callback sees each of them pinned and with its contents.
+  std::atomic<int> loaded = 0;
+  std::vector<page_id_t> page_ids{0, 1, 2, 3};
+  bpm->PrefetchPages(page_ids, [&loaded](Page *page) {
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page->GetPageId())).c_str()));
+    ++loaded;
+  });
+  for (int i = 0; i < 1000 && loaded < static_cast<int>(page_ids.size()); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(page_ids.size(), loaded);
+
+  // Scenario: the prefetched pages are resident but not left pinned.
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, OptimisticReadTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: a resident page can be looked up without pinning it, and an undisturbed read validates.
+  EXPECT_EQ(page, bpm->PeekPage(page_id));
+  EXPECT_EQ(0, page->GetPinCount());
+  uint64_t version;
+  EXPECT_EQ(true, page->OptimisticReadBegin(&version));
+  EXPECT_EQ(true, page->OptimisticReadValidate(version));
+
+  // Scenario: reads cannot start while the page is write latched, and reads that overlapped the latch fail.
+  page->WLatch();
+  uint64_t latched_version;
+  EXPECT_EQ(false, page->OptimisticReadBegin(&latched_version));
+  page->WUnlatch();
+  EXPECT_EQ(false, page->OptimisticReadValidate(version));
+  EXPECT_EQ(true, page->OptimisticReadBegin(&version));
+
+  // Scenario: a read that overlapped the frame being handed to another page fails, and the old page is gone.
+  page_id_t other_page_id;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(other_page_id, false));
+  }
+  EXPECT_EQ(false, page->OptimisticReadValidate(version));
+  EXPECT_EQ(nullptr, bpm->PeekPage(page_id));
+
+  // Scenario: only resident pages are pinned on the optimistic path, and the pin keeps the page from being deleted.
+  EXPECT_EQ(false, bpm->FetchResidentPageRead(page_id).IsValid());
+  EXPECT_EQ(nullptr, bpm->PeekPage(page_id));
+  {
+    ReadPageGuard guard = bpm->FetchResidentPageRead(other_page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ(other_page_id, guard.PageId());
+    EXPECT_EQ(false, bpm->DeletePage(other_page_id));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(other_page_id));
+  EXPECT_EQ(false, bpm->FetchResidentPageRead(other_page_id).IsValid());
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t max_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU, max_pool_size);
+  EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+
+  // Scenario: fill the pool with dirty pages, all of them pinned.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: growing adds free frames, up to the maximum size.
+  EXPECT_EQ(false, bpm->ResizePool(max_pool_size + 1));
+  EXPECT_EQ(true, bpm->ResizePool(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  for (size_t i = buffer_pool_size; i < max_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: shrinking stops at the first frame from the end whose page is pinned.
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids.back(), true));
+  EXPECT_EQ(false, bpm->ResizePool(buffer_pool_size));
+  EXPECT_EQ(max_pool_size - 1, bpm->GetPoolSize());
+
+  // Scenario: once everything is unpinned, shrinking evicts the pages of the frames it gives up and writes them back.
+  for (page_id_t page_id : page_ids) {
+    bpm->UnpinPage(page_id, true);
+  }
+  EXPECT_EQ(true, bpm->ResizePool(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the pool only uses its remaining frames.
+  auto *page0 = bpm->FetchPage(page_ids[0]);
+  auto *page1 = bpm->FetchPage(page_ids[1]);
+  ASSERT_NE(nullptr, page0);
+  ASSERT_NE(nullptr, page1);
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+  EXPECT_EQ(false, bpm->ResizePool(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, HotSetTest) {
+  const std::string db_name = "test.db";
+  const std::string hot_set_name = "test.hotset";
+  const size_t buffer_pool_size = 5;
+  const int num_pages = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: write twice as many pages as fit into the pool, so pages 5 to 9 stay resident.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: the hot set lists the resident pages in LRU order, and the pinned page last.
+  for (page_id_t page_id : {7, 5}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(9));
+  EXPECT_EQ((std::vector<page_id_t>{6, 8, 7, 5, 9}), bpm->GetHotSet());
+  EXPECT_EQ(true, bpm->SaveHotSet(hot_set_name));
+  EXPECT_EQ(true, bpm->UnpinPage(9, false));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Scenario: a restarted, smaller pool loads the hottest pages that fit and restores their order.
+  bpm = new BufferPoolManagerInstance(3, disk_manager);
+  EXPECT_EQ(false, bpm->LoadHotSet("missing.hotset"));
+  EXPECT_EQ(true, bpm->LoadHotSet(hot_set_name));
+  const std::vector<page_id_t> expected{7, 5, 9};
+  for (int i = 0; i < 1000 && bpm->GetHotSet() != expected; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(expected, bpm->GetHotSet());
+  for (page_id_t page_id : expected) {
+    auto *page = bpm->PeekPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+  }
+
+  // Scenario: the coldest warmed-up page is evicted first.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(nullptr, bpm->PeekPage(7));
+  EXPECT_NE(nullptr, bpm->PeekPage(5));
+
+  // Scenario: a page deleted after the hot set was taken is not warmed up, so a new page can take over its id.
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  const std::vector<page_id_t> hot_set = bpm->GetHotSet();
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  delete bpm;
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->WarmUp(hot_set);
+  for (int i = 0; i < 1000 && bpm->GetHotSet().size() < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2, bpm->GetHotSet().size());
+  EXPECT_EQ(nullptr, bpm->PeekPage(5));
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(5, page_id);
+  size_t frames = 0;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    frames += bpm->GetPages()[i].GetPageId() == page_id ? 1 : 0;
+  }
+  EXPECT_EQ(1, frames);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Shutdown the disk manager and remove the temporary files we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.hotset");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, FlushAllTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages, leaving one of them pinned.
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    pages.push_back(page);
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_EQ(buffer_pool_size, bpm->GetDirtyPageNum());
+
+  // Scenario: a flush writes every dirty page once, pinned or not, and leaves them all clean.
+  const int writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  EXPECT_EQ(0, bpm->GetDirtyPageNum());
+  for (auto *page : pages) {
+    EXPECT_FALSE(page->IsDirty());
+  }
+
+  // Scenario: only pages that were dirtied again are written by the next flush.
+  EXPECT_EQ(true, bpm->UnpinPage(3, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(7));
+  EXPECT_EQ(true, bpm->UnpinPage(7, true));
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(buffer_pool_size) + 2, disk_manager->GetNumWrites());
+  delete bpm;
+
+  // Scenario: the pages read back from disk with their contents.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto page_id = static_cast<page_id_t>(i);
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, DeletedPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: a deleted page cannot be fetched back into the pool.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(true, bpm->DeletePage(page_id));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_id));
+
+  // Scenario: the id is reused by the next new page, and exactly one frame holds it.
+  page_id_t reused_page_id;
+  auto *page = bpm->NewPage(&reused_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page_id, reused_page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "reused");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  size_t frames = 0;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    frames += bpm->GetPages()[i].GetPageId() == page_id ? 1 : 0;
+  }
+  EXPECT_EQ(1, frames);
+
+  // Scenario: once evicted, the page reads back with the new page's contents.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t other_page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&other_page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(other_page_id, false));
+  }
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "reused"));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a trace keeps only the most recent accesses.
+  AccessTrace trace(4);
+  bpm->SetAccessTrace(&trace);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_EQ(true, bpm->UnpinPage(3, false));
+  bpm->SetAccessTrace(nullptr);
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_EQ(5, trace.GetNumRecorded());
+  std::vector<AccessTrace::Entry> entries = trace.GetEntries();
+  ASSERT_EQ(4, entries.size());
+  EXPECT_EQ(AccessType::EVICT, entries[0].type_);
+  EXPECT_EQ(0, entries[0].page_id_);
+  EXPECT_EQ(AccessType::UNPIN, entries[1].type_);
+  EXPECT_EQ(AccessType::HIT, entries[2].type_);
+  EXPECT_EQ(3, entries[2].page_id_);
+  EXPECT_EQ(AccessType::UNPIN, entries[3].type_);
+  for (size_t i = 1; i < entries.size(); ++i) {
+    EXPECT_LE(entries[i - 1].time_ns_, entries[i].time_ns_);
+  }
+  EXPECT_TRUE(trace.Dump("test.trace"));
+  std::ifstream dump("test.trace");
+  uint64_t time_ns;
+  std::string type;
+  page_id_t dumped_page_id;
+  dump >> time_ns >> type >> dumped_page_id;
+  EXPECT_EQ(entries[0].time_ns_, time_ns);
+  EXPECT_EQ("evict", type);
+  EXPECT_EQ(0, dumped_page_id);
+  remove("test.trace");
+
+  // Scenario: a miss evicts a dirty page, and a fetch fails once every frame is pinned.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(true, bpm->FlushPage(2));
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.writebacks_);
+  EXPECT_EQ(1, stats.flushes_);
+  EXPECT_EQ(1, stats.pin_failures_);
+  EXPECT_EQ(0, stats.compressed_hits_ + stats.compressed_misses_);
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
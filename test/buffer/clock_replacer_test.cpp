@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <cstdio>
 #include <thread>  // NOLINT
 #include <vector>
@@ -19,7 +20,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +60,53 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_frames = 64;
+  const int num_threads = 8;
+  const int rounds = 10000;
+  ClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread owns a disjoint set of frames and keeps unpinning and pinning them while another thread
+  // evicts whatever it can.
+  std::atomic<bool> done{false};
+  std::thread evictor([&clock_replacer, &done] {
+    int value;
+    while (!done.load()) {
+      clock_replacer.Victim(&value);
+    }
+  });
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, tid] {
+      for (int i = 0; i < rounds; i++) {
+        for (frame_id_t frame_id = tid; frame_id < num_frames; frame_id += num_threads) {
+          clock_replacer.Unpin(frame_id);
+          clock_replacer.Pin(frame_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  evictor.join();
+  EXPECT_EQ(0, clock_replacer.Size());
+
+  // Scenario: once every frame is unpinned again, each one is handed out as a victim exactly once.
+  for (frame_id_t frame_id = 0; frame_id < num_frames; frame_id++) {
+    clock_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+  std::vector<bool> seen(num_frames, false);
+  int value;
+  for (int i = 0; i < num_frames; i++) {
+    ASSERT_TRUE(clock_replacer.Victim(&value));
+    EXPECT_FALSE(seen[value]);
+    seen[value] = true;
+  }
+  EXPECT_FALSE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/compressed_page_cache.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(CompressedPageCacheTest, CompressionTest) {
+  std::vector<char> compressed;
+  char page[PAGE_SIZE];
+  char restored[PAGE_SIZE];
+
+  // Scenario: a zeroed page shrinks to a few bytes.
+  memset(page, 0, PAGE_SIZE);
+  EXPECT_TRUE(CompressedPageCache::Compress(page, &compressed));
+  EXPECT_LT(compressed.size(), 128);
+  CompressedPageCache::Decompress(compressed, restored);
+  EXPECT_EQ(0, memcmp(page, restored, PAGE_SIZE));
+
+  // Scenario: a page of repetitive tuples compresses well and comes back unchanged.
+  memset(page, 0, PAGE_SIZE);
+  const int tuple_size = 64;
+  for (int offset = 0, i = 0; offset + tuple_size <= PAGE_SIZE / 2; offset += tuple_size, i++) {
+    snprintf(page + offset, tuple_size, "tuple %04d | customer-%d | status=ACTIVE", i, i % 7);
+  }
+  EXPECT_TRUE(CompressedPageCache::Compress(page, &compressed));
+  EXPECT_LT(compressed.size(), PAGE_SIZE / 4);
+  CompressedPageCache::Decompress(compressed, restored);
+  EXPECT_EQ(0, memcmp(page, restored, PAGE_SIZE));
+
+  // Scenario: random bytes do not compress.
+  std::mt19937 rng(15445);
+  for (char &byte : page) {
+    byte = static_cast<char>(rng());
+  }
+  EXPECT_FALSE(CompressedPageCache::Compress(page, &compressed));
+}
+
+TEST(CompressedPageCacheTest, CacheTest) {
+  char page[PAGE_SIZE];
+  char restored[PAGE_SIZE];
+  std::mt19937 rng(15445);
+  for (char &byte : page) {
+    byte = static_cast<char>(rng());
+  }
+
+  // Scenario: the cache holds two uncompressible pages at most, and drops the oldest one to make room.
+  CompressedPageCache cache(2 * PAGE_SIZE);
+  cache.Insert(0, page);
+  cache.Insert(1, page);
+  cache.Insert(2, page);
+  EXPECT_EQ(2, cache.GetSize());
+  EXPECT_EQ(2 * PAGE_SIZE, cache.GetUsedBytes());
+  EXPECT_FALSE(cache.Take(0, restored));
+
+  // Scenario: a hit hands the page out and removes it from the cache.
+  EXPECT_TRUE(cache.Take(1, restored));
+  EXPECT_EQ(0, memcmp(page, restored, PAGE_SIZE));
+  EXPECT_FALSE(cache.Take(1, restored));
+  EXPECT_EQ(1, cache.GetHits());
+  EXPECT_EQ(2, cache.GetMisses());
+
+  // Scenario: reinserting a page replaces its old copy, and erasing drops it.
+  memset(page, 0, PAGE_SIZE);
+  cache.Insert(2, page);
+  EXPECT_EQ(1, cache.GetSize());
+  EXPECT_LT(cache.GetUsedBytes(), PAGE_SIZE);
+  cache.Erase(2);
+  EXPECT_EQ(0, cache.GetSize());
+  EXPECT_EQ(0, cache.GetUsedBytes());
+}
+
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU, 0,
+                                            num_pages * PAGE_SIZE);
+  CompressedPageCache *cache = bpm->GetCompressedCache();
+  ASSERT_NE(nullptr, cache);
+
+  // Scenario: evicted pages, dirty or not, land in the cache.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(num_pages - buffer_pool_size, cache->GetSize());
+
+  // Scenario: re-fetching an evicted page is a cache hit with the page's latest contents.
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(i)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(num_pages, cache->GetHits());
+  EXPECT_EQ(0, cache->GetMisses());
+
+  // Scenario: a deleted page does not come back from the cache.
+  EXPECT_EQ(true, bpm->DeletePage(0));
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  EXPECT_EQ(num_pages - buffer_pool_size - 2, cache->GetSize());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
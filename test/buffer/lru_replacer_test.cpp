@@ -59,4 +59,26 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(LRUReplacerTest, PreferredVictimTest) {
+  LRUReplacer lru_replacer(7);
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_replacer.Unpin(frame_id);
+  }
+
+  // Scenario: only even frames are preferred, so they are evicted in LRU order first.
+  auto even = [](frame_id_t frame_id) { return frame_id % 2 == 0; };
+  int value;
+  EXPECT_TRUE(lru_replacer.PreferredVictim(&value, even));
+  EXPECT_EQ(2, value);
+  EXPECT_TRUE(lru_replacer.PreferredVictim(&value, even));
+  EXPECT_EQ(4, value);
+  EXPECT_TRUE(lru_replacer.PreferredVictim(&value, even));
+  EXPECT_EQ(6, value);
+
+  // Scenario: once no frame is preferred, the least recently used one is evicted.
+  EXPECT_TRUE(lru_replacer.PreferredVictim(&value, even));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(2, lru_replacer.Size());
+}
+
 }  // namespace bustub
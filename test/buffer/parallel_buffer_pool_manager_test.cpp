@@ -11,11 +11,15 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <string>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -151,4 +155,226 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, 2, disk_manager, nullptr, ReplacerType::LRU, 4);
+  EXPECT_EQ(6, bpm->GetPoolSize());
+
+  // Scenario: the new total is spread over the instances, within each instance's maximum.
+  EXPECT_EQ(true, bpm->ResizePool(10));
+  EXPECT_EQ(10, bpm->GetPoolSize());
+  EXPECT_EQ(false, bpm->ResizePool(13));
+  EXPECT_EQ(12, bpm->GetPoolSize());
+  EXPECT_EQ(false, bpm->ResizePool(num_instances - 1));
+
+  // Scenario: pages survive a shrink.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 12; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(true, bpm->ResizePool(num_instances));
+  EXPECT_EQ(num_instances, bpm->GetPoolSize());
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(ParallelBufferPoolManagerTest, AllocationTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t instance_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+
+  // Scenario: new pages are spread evenly over the instances, and each is fetched from the instance that made it.
+  std::vector<size_t> per_instance(num_instances, 0);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * instance_pool_size; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    per_instance[page_id % num_instances]++;
+    page_ids.push_back(page_id);
+  }
+  for (size_t count : per_instance) {
+    EXPECT_EQ(instance_pool_size, count);
+  }
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: with every frame pinned there is no room for a new page, until one instance frees a frame.
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(true, bpm->UnpinPage(page_ids[5], true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids[5] % num_instances, page_id % num_instances);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(ParallelBufferPoolManagerTest, DeallocationTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t instance_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * instance_pool_size; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the id of a deleted page is reused by the instance it maps to, before any new id.
+  EXPECT_EQ(true, bpm->DeletePage(page_ids[6]));
+  EXPECT_FALSE(disk_manager->IsPageAllocated(page_ids[6]));
+  std::vector<page_id_t> new_page_ids;
+  for (size_t i = 0; i < num_instances; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    new_page_ids.push_back(page_id);
+  }
+  EXPECT_NE(new_page_ids.end(), std::find(new_page_ids.begin(), new_page_ids.end(), page_ids[6]));
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: after a restart, new pages do not overwrite the pages allocated before it.
+  disk_manager = new DiskManager(db_name);
+  bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids.end(), std::find(page_ids.begin(), page_ids.end(), page_id));
+  EXPECT_EQ(new_page_ids.end(), std::find(new_page_ids.begin(), new_page_ids.end(), page_id));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(ParallelBufferPoolManagerTest, SegmentTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t instance_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+
+  // Scenario: pages created in turns for two segments are contiguous within each segment's extents.
+  Segment segments[2] = {Segment(8), Segment(8)};
+  std::vector<page_id_t> page_ids[2];
+  for (size_t i = 0; i < 20; ++i) {
+    for (size_t s = 0; s < 2; ++s) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPageInSegment(&page_id, &segments[s]));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      page_ids[s].push_back(page_id);
+    }
+  }
+  for (auto &segment_page_ids : page_ids) {
+    for (size_t i = 1; i < segment_page_ids.size(); ++i) {
+      if (i % 8 != 0) {
+        EXPECT_EQ(segment_page_ids[i - 1] + 1, segment_page_ids[i]);
+      }
+    }
+    EXPECT_EQ(0, segment_page_ids[0] % 8);
+  }
+  // single pages are allocated around the extents
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(std::find(page_ids[0].begin(), page_ids[0].end(), page_id) == page_ids[0].end());
+  EXPECT_TRUE(std::find(page_ids[1].begin(), page_ids[1].end(), page_id) == page_ids[1].end());
+
+  // Scenario: a page id is not used up when its instance has no free frame.
+  Segment segment(8);
+  ASSERT_NE(nullptr, bpm->NewPageInSegment(&page_id, &segment));
+  const page_id_t first_page_id = page_id;
+  std::vector<page_id_t> pinned_page_ids;
+  while (bpm->NewPage(&page_id) != nullptr) {
+    pinned_page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPageInSegment(&page_id, &segment));
+  for (page_id_t pinned_page_id : pinned_page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(pinned_page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->NewPageInSegment(&page_id, &segment));
+  EXPECT_EQ(first_page_id + 1, page_id);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// counts the syncs of the database file
+class SyncCountingDiskManager : public DiskManagerMemory {
+ public:
+  void Sync() override { num_syncs_++; }
+
+  size_t num_syncs_{0};
+};
+
+TEST(ParallelBufferPoolManagerTest, FlushAllTest) {
+  const size_t num_instances = 4;
+  const size_t instance_pool_size = 4;
+
+  auto *disk_manager = new SyncCountingDiskManager();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, instance_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * instance_pool_size; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: all instances write their dirty pages, and the file is synced once.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->num_syncs_);
+  char data[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(data));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
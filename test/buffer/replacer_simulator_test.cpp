@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_simulator_test.cpp
+//
+// Identification: test/buffer/replacer_simulator_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/access_trace.h"
+#include "buffer/replacer_simulator.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ReplacerSimulatorTest, ReplayTest) {
+  const size_t pool_size = 8;
+  const ReplacerType types[] = {ReplacerType::LRU, ReplacerType::LRUK, ReplacerType::CLOCK};
+
+  // Scenario: a working set that fits into the pool only takes cold misses.
+  std::vector<page_id_t> references;
+  for (int round = 0; round < 10; ++round) {
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(pool_size); ++page_id) {
+      references.push_back(page_id);
+    }
+  }
+  for (ReplacerType type : types) {
+    auto result = ReplacerSimulator::Replay(ReplacerSimulator::FactoryFor(type), pool_size, references);
+    EXPECT_EQ(pool_size, result.misses_);
+    EXPECT_EQ(references.size() - pool_size, result.hits_);
+  }
+
+  // Scenario: a loop over one page more than the pool holds never hits under LRU.
+  references.clear();
+  for (int round = 0; round < 10; ++round) {
+    for (page_id_t page_id = 0; page_id <= static_cast<page_id_t>(pool_size); ++page_id) {
+      references.push_back(page_id);
+    }
+  }
+  auto lru = ReplacerSimulator::Replay(ReplacerSimulator::FactoryFor(ReplacerType::LRU), pool_size, references);
+  EXPECT_EQ(0, lru.hits_);
+  EXPECT_EQ(0, lru.HitRatio());
+
+  // Scenario: scans push the popular pages out of an LRU pool, but not out of an LRU-K pool.
+  references = ReplacerSimulator::ScanMixedTrace(2000, 50000, 0.99, 0.5, 64, 15445);
+  EXPECT_EQ(50000, references.size());
+  lru = ReplacerSimulator::Replay(ReplacerSimulator::FactoryFor(ReplacerType::LRU), 100, references);
+  auto lru_k = ReplacerSimulator::Replay(ReplacerSimulator::FactoryFor(ReplacerType::LRUK), 100, references);
+  EXPECT_GT(lru_k.HitRatio(), lru.HitRatio());
+}
+
+TEST(ReplacerSimulatorTest, LoadTraceTest) {
+  // Scenario: only the references of a dumped access trace are replayed.
+  AccessTrace trace(16);
+  trace.Record(1, AccessType::NEW);
+  trace.Record(1, AccessType::UNPIN);
+  trace.Record(1, AccessType::HIT);
+  trace.Record(0, AccessType::EVICT);
+  trace.Record(2, AccessType::MISS);
+  ASSERT_TRUE(trace.Dump("test.trace"));
+  std::vector<page_id_t> references;
+  ASSERT_TRUE(ReplacerSimulator::LoadTrace("test.trace", &references));
+  EXPECT_EQ((std::vector<page_id_t>{1, 1, 2}), references);
+  remove("test.trace");
+
+  EXPECT_FALSE(ReplacerSimulator::LoadTrace("test.trace", &references));
+}
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_memory_test.cpp
+//
+// Identification: test/storage/disk_manager_memory_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(DiskManagerMemoryTest, ReadWritePageTest) {
+  char buf[PAGE_SIZE];
+  char data[PAGE_SIZE] = {0};
+  DiskManagerMemory dm;
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Scenario: a page that was never written reads as zeros, and pages are stored sparsely.
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(1000000, buf);
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buf, PAGE_SIZE));
+  dm.WritePage(1000000, data);
+  dm.ReadPage(1000000, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(1, dm.GetNumPages());
+  EXPECT_EQ(1, dm.GetNumWrites());
+
+  // Scenario: several pages are written and read at once.
+  char pages[2][PAGE_SIZE] = {{0}};
+  dm.WritePages({{5, data}, {4, buf}});
+  dm.ReadPages({{4, pages[0]}, {5, pages[1]}});
+  EXPECT_EQ(std::memcmp(pages[0], buf, sizeof(buf)), 0);
+  EXPECT_EQ(std::memcmp(pages[1], data, sizeof(data)), 0);
+
+  // Scenario: asynchronous requests complete.
+  std::memset(buf, 0, sizeof(buf));
+  EXPECT_TRUE(dm.WritePageAsync(3, data).get());
+  EXPECT_TRUE(dm.ReadPageAsync(3, buf).get());
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Scenario: the log reads back from any offset.
+  char log[16] = "A log record.";
+  char log_buf[16];
+  EXPECT_FALSE(dm.ReadLog(log_buf, sizeof(log_buf), 0));
+  dm.WriteLog(log, sizeof(log));
+  EXPECT_TRUE(dm.ReadLog(log_buf, sizeof(log_buf), 2));
+  EXPECT_STREQ("log record.", log_buf);
+  EXPECT_EQ(1, dm.GetNumFlushes());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerMemoryTest, LatencyModelTest) {
+  char data[PAGE_SIZE] = {0};
+
+  // Scenario: every read waits for the read latency.
+  DiskLatencyModel latency;
+  latency.read_latency_ = std::chrono::milliseconds(2);
+  DiskManagerMemory slow_reads(latency);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; i++) {
+    slow_reads.ReadPage(i, data);
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+  // Scenario: concurrent writes share the bandwidth, 100 pages a second here.
+  latency = DiskLatencyModel{};
+  latency.bandwidth_ = 100 * PAGE_SIZE;
+  DiskManagerMemory slow_writes(latency);
+  start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; tid++) {
+    threads.emplace_back([&slow_writes, tid] {
+      char page[PAGE_SIZE] = {0};
+      for (int i = 0; i < 5; i++) {
+        slow_writes.WritePage(tid * 5 + i, page);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(200));
+  EXPECT_EQ(20, slow_writes.GetNumPages());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskManagerMemoryTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 4;
+  DiskManagerMemory dm;
+  BufferPoolManagerInstance bpm(buffer_pool_size, &dm);
+
+  // Scenario: pages evicted to the in-memory disk come back with their contents.
+  for (int i = 0; i < 16; ++i) {
+    page_id_t page_id;
+    auto *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  for (page_id_t page_id = 0; page_id < 16; ++page_id) {
+    auto *page = bpm.FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(16, dm.GetNumPages());
+}
+
+}  // namespace bustub
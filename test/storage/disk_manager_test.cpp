@@ -10,7 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
 #include <cstring>
+#include <string>
+#include <future>  // NOLINT
+#include <limits>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -55,6 +64,181 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: threads write and read back interleaved pages at the same time.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id, sizeof(data));
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  dm.Sync();
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  // Scenario: every page survives, and a page past the end of the file reads as zeros.
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; page_id++) {
+    std::memset(data, page_id, sizeof(data));
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  }
+  std::memset(data, 0, sizeof(data));
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(num_threads * pages_per_thread, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  const int num_pages = 256;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  // io_uring may be missing or forbidden; the requests must complete either way
+  printf("asynchronous I/O through io_uring: %s\n", dm.IsAsyncIoAvailable() ? "yes" : "no");
+
+  // Scenario: a batch of more writes than the ring holds completes, and the pages read back asynchronously.
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> done;
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    std::memset(data[page_id].data(), page_id, PAGE_SIZE);
+    requests.push_back(DiskRequest{true, data[page_id].data(), page_id, {}});
+    done.push_back(requests.back().callback_.get_future());
+  }
+  dm.SubmitBatch(&requests);
+  EXPECT_TRUE(requests.empty());
+  for (auto &write : done) {
+    EXPECT_TRUE(write.get());
+  }
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    EXPECT_TRUE(dm.ReadPageAsync(page_id, buf).get());
+    EXPECT_EQ(std::memcmp(buf, data[page_id].data(), PAGE_SIZE), 0);
+  }
+
+  // Scenario: an asynchronous read past the end of the file reads zeros, and a single write lands.
+  std::memset(buf, 1, sizeof(buf));
+  EXPECT_TRUE(dm.ReadPageAsync(num_pages + 1, buf).get());
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf, buf + PAGE_SIZE));
+  EXPECT_TRUE(dm.WritePageAsync(num_pages, data[7].data()).get());
+  dm.ReadPage(num_pages, buf);
+  EXPECT_EQ(std::memcmp(buf, data[7].data(), PAGE_SIZE), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, true);
+  // the file system may not support O_DIRECT; the pages must come back either way
+  printf("direct I/O: %s\n", dm.IsDirectIo() ? "yes" : "no");
+
+  // Scenario: aligned and unaligned buffers both work.
+  alignas(PAGE_SIZE) char aligned[PAGE_SIZE];
+  std::vector<char> unaligned_storage(PAGE_SIZE + 1);
+  char *unaligned = unaligned_storage.data() + 1;
+  std::strncpy(aligned, "An aligned page.", sizeof(aligned));
+  std::strncpy(unaligned, "An unaligned page.", PAGE_SIZE);
+  dm.WritePage(0, aligned);
+  dm.WritePage(1, unaligned);
+  dm.ReadPage(0, unaligned);
+  EXPECT_STREQ("An aligned page.", unaligned);
+  dm.ReadPage(1, aligned);
+  EXPECT_STREQ("An unaligned page.", aligned);
+
+  // Scenario: a batch mixing aligned and unaligned buffers completes.
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> done;
+  requests.push_back(DiskRequest{false, aligned, 0, {}});
+  requests.push_back(DiskRequest{false, unaligned, 1, {}});
+  for (auto &request : requests) {
+    done.push_back(request.callback_.get_future());
+  }
+  dm.SubmitBatch(&requests);
+  EXPECT_TRUE(done[0].get());
+  EXPECT_TRUE(done[1].get());
+  EXPECT_STREQ("An aligned page.", aligned);
+  EXPECT_STREQ("An unaligned page.", unaligned);
+
+  // Scenario: a partial page at the end of the file reads as its bytes followed by zeros.
+  std::memset(aligned, 'x', sizeof(aligned));
+  dm.WritePage(2, aligned);
+  dm.Sync();
+  ASSERT_EQ(0, truncate("test.db", DiskManager::PageOffset(2) + 100));
+  std::memset(aligned, 1, sizeof(aligned));
+  dm.ReadPage(2, aligned);
+  EXPECT_EQ(std::string(100, 'x') + std::string(PAGE_SIZE - 100, '\0'), std::string(aligned, PAGE_SIZE));
+  std::memset(aligned, 1, sizeof(aligned));
+  EXPECT_TRUE(dm.ReadPageAsync(2, aligned).get());
+  EXPECT_EQ(std::string(100, 'x') + std::string(PAGE_SIZE - 100, '\0'), std::string(aligned, PAGE_SIZE));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, VectoredReadWritePageTest) {
+  const auto group_end = static_cast<page_id_t>(DiskManager::PAGES_PER_BITMAP);
+  // adjacent pages, a gap, pages on both sides of a bitmap page, and a page written twice
+  const std::vector<page_id_t> page_ids = {7, 3, 4, 5, group_end, group_end - 1, 4};
+  for (bool direct_io : {false, true}) {
+    remove("test.db");
+    auto dm = DiskManager("test.db", direct_io);
+    alignas(PAGE_SIZE) static char data[8][PAGE_SIZE];
+    std::vector<std::pair<page_id_t, const char *>> writes;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      snprintf(data[i], PAGE_SIZE, "page %d, write %zu", page_ids[i], i);
+      writes.emplace_back(page_ids[i], data[i]);
+    }
+    dm.WritePages(writes);
+    EXPECT_EQ(page_ids.size(), dm.GetNumWrites());
+
+    // Scenario: every page reads back, the later of two writes wins, and pages past the end of the file are zeros.
+    alignas(PAGE_SIZE) static char buf[8][PAGE_SIZE + 1];
+    std::memset(buf, 1, sizeof(buf));
+    // one unaligned buffer, which direct I/O reads through the bounce buffer
+    std::vector<std::pair<page_id_t, char *>> reads = {
+        {3, buf[0]},     {4, buf[1]},             {5, buf[2]},         {6, buf[3]},
+        {7, buf[4] + 1}, {group_end - 1, buf[5]}, {group_end, buf[6]}, {group_end + 1, buf[7]}};
+    dm.ReadPages(reads);
+    EXPECT_STREQ("page 3, write 1", buf[0]);
+    EXPECT_STREQ("page 4, write 6", buf[1]);
+    EXPECT_STREQ("page 5, write 3", buf[2]);
+    EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buf[3], PAGE_SIZE));
+    EXPECT_STREQ("page 7, write 0", buf[4] + 1);
+    EXPECT_STREQ(("page " + std::to_string(group_end - 1) + ", write 5").c_str(), buf[5]);
+    EXPECT_STREQ(("page " + std::to_string(group_end) + ", write 4").c_str(), buf[6]);
+    EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buf[7], PAGE_SIZE));
+    for (const auto &[page_id, page_data] : reads) {
+      char page[PAGE_SIZE];
+      dm.ReadPage(page_id, page);
+      EXPECT_EQ(0, std::memcmp(page, page_data, PAGE_SIZE));
+    }
+    dm.ShutDown();
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -72,6 +256,169 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::strncpy(data, "A page past 2 GB.", sizeof(data));
+  // the first page id whose offset does not fit into 32 bits, and the last page id
+  const page_id_t page_ids[] = {static_cast<page_id_t>((1LL << 32) / PAGE_SIZE),
+                                std::numeric_limits<page_id_t>::max()};
+
+  // Scenario: pages past 4 GB land at their own offsets, in a sparse file.
+  auto dm = DiskManager("test.db");
+  for (page_id_t page_id : page_ids) {
+    dm.WritePage(page_id, data);
+    std::memset(buf, 0, sizeof(buf));
+    dm.ReadPage(page_id, buf);
+    EXPECT_STREQ("A page past 2 GB.", buf);
+    std::memset(buf, 0, sizeof(buf));
+    EXPECT_TRUE(dm.ReadPageAsync(page_id, buf).get());
+    EXPECT_STREQ("A page past 2 GB.", buf);
+  }
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(buf, PAGE_SIZE));
+  dm.ShutDown();
+
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_EQ(DiskManager::PageOffset(page_ids[1]) + PAGE_SIZE, stat_buf.st_size);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FormatVersionTest) {
+  char buf[PAGE_SIZE] = {0};
+  char data[PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  // Scenario: a database file is reopened with its pages.
+  {
+    auto dm = DiskManager("test.db");
+    dm.WritePage(0, data);
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManager("test.db");
+    dm.ReadPage(0, buf);
+    EXPECT_STREQ("A test string.", buf);
+    dm.ShutDown();
+  }
+
+  // Scenario: a file of another format version is rejected.
+  const uint32_t version = DiskManager::FORMAT_VERSION + 1;
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(0, fseek(file, 8, SEEK_SET));
+  ASSERT_EQ(1, fwrite(&version, sizeof(version), 1, file));
+  fclose(file);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+
+  // Scenario: a file that is not a database file is rejected.
+  file = fopen("test.db", "wb");
+  ASSERT_NE(nullptr, file);
+  ASSERT_EQ(1, fwrite(data, sizeof(data), 1, file));
+  fclose(file);
+  EXPECT_THROW(DiskManager("test.db"), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocatePageTest) {
+  {
+    auto dm = DiskManager("test.db");
+    // Scenario: pages are allocated in order, and every stride and offset only gets its own ids.
+    for (page_id_t page_id = 0; page_id < 4; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    EXPECT_EQ(5, dm.AllocatePage(4, 1));
+    EXPECT_EQ(6, dm.AllocatePage(4, 2));
+    EXPECT_EQ(4, dm.AllocatePage());
+    EXPECT_EQ(7, dm.AllocatePage());
+    EXPECT_EQ(9, dm.AllocatePage(4, 1));
+
+    // Scenario: freed ids are reused lowest first, before the file is extended, by the class they map to.
+    dm.DeallocatePage(6);
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(2);
+    EXPECT_FALSE(dm.IsPageAllocated(2));
+    EXPECT_EQ(13, dm.AllocatePage(4, 1));
+    EXPECT_EQ(2, dm.AllocatePage(4, 2));
+    EXPECT_EQ(6, dm.AllocatePage());
+    EXPECT_EQ(8, dm.AllocatePage());
+
+    // Scenario: a freed page is reused past the first group of pages too.
+    const auto far_page = static_cast<page_id_t>(DiskManager::PAGES_PER_BITMAP + 3);
+    while (dm.AllocatePage(4, 3) != far_page) {
+    }
+    dm.DeallocatePage(far_page);
+    dm.DeallocatePage(3);
+    dm.ShutDown();
+  }
+
+  // Scenario: allocations survive a restart.
+  auto dm = DiskManager("test.db");
+  EXPECT_TRUE(dm.IsPageAllocated(0));
+  EXPECT_TRUE(dm.IsPageAllocated(13));
+  EXPECT_TRUE(dm.IsPageAllocated(static_cast<page_id_t>(DiskManager::PAGES_PER_BITMAP - 1)));
+  EXPECT_FALSE(dm.IsPageAllocated(3));
+  EXPECT_FALSE(dm.IsPageAllocated(10));
+  EXPECT_EQ(3, dm.AllocatePage(4, 3));
+  EXPECT_EQ(10, dm.AllocatePage(4, 2));
+  EXPECT_EQ(12, dm.AllocatePage());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocateExtentTest) {
+  {
+    auto dm = DiskManager("test.db");
+
+    // Scenario: extents are aligned runs of free pages, which single page allocations then skip.
+    EXPECT_EQ(0, dm.AllocatePage());
+    std::shared_ptr<Extent> first = dm.AllocateExtent(8);
+    std::shared_ptr<Extent> second = dm.AllocateExtent(8);
+    EXPECT_EQ(8, first->first_page_id_);
+    EXPECT_EQ(16, second->first_page_id_);
+    for (page_id_t page_id = 8; page_id < 24; page_id++) {
+      EXPECT_TRUE(dm.IsPageAllocated(page_id));
+    }
+    for (page_id_t page_id = 1; page_id < 8; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+    }
+    EXPECT_EQ(24, dm.AllocatePage());
+    EXPECT_EQ(25, dm.AllocatePage(4, 1));
+
+    // Scenario: an extent reuses an aligned run that was freed.
+    first->next_page_id_ = first->end_page_id_;
+    for (page_id_t page_id = 8; page_id < 16; page_id++) {
+      dm.DeallocatePage(page_id);
+    }
+    std::shared_ptr<Extent> third = dm.AllocateExtent(8);
+    std::shared_ptr<Extent> fourth = dm.AllocateExtent(8);
+    EXPECT_EQ(8, third->first_page_id_);
+    EXPECT_EQ(32, fourth->first_page_id_);
+    EXPECT_EQ(29, dm.AllocatePage(4, 1));
+
+    // Scenario: the pages of a dropped extent that were never taken are freed for the next extent.
+    second->next_page_id_ = 20;
+    second.reset();
+    EXPECT_EQ(20, dm.AllocateExtent(4)->first_page_id_);
+    EXPECT_TRUE(dm.IsPageAllocated(19));
+
+    // Scenario: only the pages taken from an extent are written to the bitmaps.
+    fourth->next_page_id_ = 34;
+    dm.ShutDown();
+  }
+
+  auto dm = DiskManager("test.db");
+  EXPECT_TRUE(dm.IsPageAllocated(19));
+  EXPECT_FALSE(dm.IsPageAllocated(20));
+  EXPECT_FALSE(dm.IsPageAllocated(8));
+  EXPECT_TRUE(dm.IsPageAllocated(33));
+  EXPECT_FALSE(dm.IsPageAllocated(34));
+  EXPECT_EQ(8, dm.AllocateExtent(8)->first_page_id_);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, BasicGuardTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  {
+    BasicPageGuard guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    snprintf(guard.AsMut<char>(), PAGE_SIZE, "Hello");
+
+    // Scenario: moving a guard hands over the pin without releasing it.
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_TRUE(moved.IsValid());
+    Page *page = bpm->FetchPage(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+    // Scenario: dropping releases the pin exactly once, and the destructor does not release it again.
+    moved.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+    moved.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+    // The guard was written through AsMut, so the page was unpinned as dirty.
+    EXPECT_TRUE(page->IsDirty());
+  }
+
+  // Scenario: assigning over a guard releases the page it held.
+  page_id_t other_page_id;
+  BasicPageGuard guard = bpm->FetchPageBasic(page_id);
+  BasicPageGuard other = bpm->NewPageGuarded(&other_page_id);
+  Page *page = bpm->FetchPage(page_id);
+  EXPECT_EQ(2, page->GetPinCount());
+  guard = std::move(other);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(other_page_id, guard.PageId());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  guard.Drop();
+
+  // Scenario: a fetch that fails leaves an invalid guard that releases nothing.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t temp_page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&temp_page_id));
+  }
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, LatchGuardTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+
+  // Scenario: several read guards share the page, and each holds its own pin.
+  {
+    ReadPageGuard reader1 = bpm->FetchPageRead(page_id);
+    ReadPageGuard reader2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    ReadPageGuard moved = std::move(reader1);
+    EXPECT_EQ(2, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: a write guard releases the latch on destruction, so another writer can take it afterwards.
+  {
+    WritePageGuard writer = bpm->FetchPageWrite(page_id);
+    snprintf(writer.AsMut<char>(), PAGE_SIZE, "Hello");
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+  std::thread other_writer([bpm, page_id] { WritePageGuard writer = bpm->FetchPageWrite(page_id); });
+  other_writer.join();
+
+  // Scenario: upgrading a basic guard latches the page and keeps a single pin.
+  BasicPageGuard basic = bpm->FetchPageBasic(page_id);
+  WritePageGuard upgraded = basic.UpgradeWrite();
+  EXPECT_FALSE(basic.IsValid());  // NOLINT
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(0, strcmp(upgraded.GetData(), "Hello"));
+  upgraded.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+  ReadPageGuard reader = bpm->FetchPageRead(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  reader.Drop();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_simulator.cpp
+//
+// Identification: test/tools/replacer_simulator.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Replays page reference strings against every replacement policy at several pool sizes and prints the hit ratio and
+// the time per reference of each combination.
+//
+//   replacer_simulator [--trace FILE] [--pages N] [--references N] [--theta T] [--scan-fraction F]
+//                      [--scan-length N] [--pool-sizes N,N,...]
+//
+// Without --trace, a Zipfian and a scan-mixed reference string are generated. A trace is a file written by
+// AccessTrace::Dump() while a workload ran against a buffer pool. Pool sizes default to 1%, 5%, 10% and 25% of the
+// distinct pages referenced.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer_simulator.h"
+
+namespace bustub {
+namespace {
+
+struct Options {
+  std::string trace_file_;
+  size_t num_pages_{10000};
+  size_t num_references_{1000000};
+  double theta_{0.99};
+  double scan_fraction_{0.5};
+  size_t scan_length_{64};
+  std::vector<size_t> pool_sizes_;
+};
+
+void Usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [--trace FILE] [--pages N] [--references N] [--theta T] [--scan-fraction F] "
+          "[--scan-length N] [--pool-sizes N,N,...]\n",
+          program);
+  exit(EXIT_FAILURE);
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+    }
+    const char *flag = argv[i];
+    const char *value = argv[++i];
+    if (strcmp(flag, "--trace") == 0) {
+      options.trace_file_ = value;
+    } else if (strcmp(flag, "--pages") == 0) {
+      options.num_pages_ = strtoul(value, nullptr, 10);
+    } else if (strcmp(flag, "--references") == 0) {
+      options.num_references_ = strtoul(value, nullptr, 10);
+    } else if (strcmp(flag, "--theta") == 0) {
+      options.theta_ = strtod(value, nullptr);
+    } else if (strcmp(flag, "--scan-fraction") == 0) {
+      options.scan_fraction_ = strtod(value, nullptr);
+    } else if (strcmp(flag, "--scan-length") == 0) {
+      options.scan_length_ = strtoul(value, nullptr, 10);
+    } else if (strcmp(flag, "--pool-sizes") == 0) {
+      std::stringstream sizes(value);
+      std::string size;
+      while (std::getline(sizes, size, ',')) {
+        options.pool_sizes_.push_back(strtoul(size.c_str(), nullptr, 10));
+      }
+    } else {
+      Usage(argv[0]);
+    }
+  }
+  if (options.num_pages_ == 0) {
+    Usage(argv[0]);
+  }
+  for (size_t pool_size : options.pool_sizes_) {
+    if (pool_size == 0) {
+      Usage(argv[0]);
+    }
+  }
+  return options;
+}
+
+void Simulate(const std::string &workload, const std::vector<page_id_t> &references, std::vector<size_t> pool_sizes) {
+  if (pool_sizes.empty()) {
+    const size_t distinct = std::unordered_set<page_id_t>(references.begin(), references.end()).size();
+    for (size_t percent : {1, 5, 10, 25}) {
+      pool_sizes.push_back(std::max<size_t>(1, distinct * percent / 100));
+    }
+  }
+  const std::pair<const char *, ReplacerType> policies[] = {
+      {"lru", ReplacerType::LRU}, {"lru-k", ReplacerType::LRUK}, {"clock", ReplacerType::CLOCK}};
+  for (size_t pool_size : pool_sizes) {
+    for (const auto &[name, type] : policies) {
+      auto result = ReplacerSimulator::Replay(ReplacerSimulator::FactoryFor(type), pool_size, references);
+      printf("%-12s %-6s %10zu %9.4f %10.1f\n", workload.c_str(), name, pool_size, result.HitRatio(),
+             result.NsPerReference());
+    }
+  }
+}
+
+}  // namespace
+}  // namespace bustub
+
+int main(int argc, char **argv) {
+  using bustub::ReplacerSimulator;
+  const bustub::Options options = bustub::ParseOptions(argc, argv);
+  printf("%-12s %-6s %10s %9s %10s\n", "workload", "policy", "pool_size", "hit_ratio", "ns/ref");
+  if (!options.trace_file_.empty()) {
+    std::vector<bustub::page_id_t> references;
+    if (!ReplacerSimulator::LoadTrace(options.trace_file_, &references)) {
+      fprintf(stderr, "could not read trace %s\n", options.trace_file_.c_str());
+      return EXIT_FAILURE;
+    }
+    bustub::Simulate("trace", references, options.pool_sizes_);
+    return EXIT_SUCCESS;
+  }
+  bustub::Simulate("zipfian",
+                   ReplacerSimulator::ZipfianTrace(options.num_pages_, options.num_references_, options.theta_, 15445),
+                   options.pool_sizes_);
+  bustub::Simulate("scan-mixed",
+                   ReplacerSimulator::ScanMixedTrace(options.num_pages_, options.num_references_, options.theta_,
+                                                     options.scan_fraction_, options.scan_length_, 15445),
+                   options.pool_sizes_);
+  return EXIT_SUCCESS;
+}